@@ -1,20 +1,54 @@
 #version 420
 
+//FUSED_POST is defined when this is pasted into a fused post shader,
+//which declares the inputs and main itself
+#ifndef FUSED_POST
 layout(location = 0) in vec2 inUV;
 
 out vec4 frag_color;
 
 layout (binding = 0) uniform sampler2D u_FinishedFrame;
-layout (binding = 30) uniform sampler3D u_TexColorGrade;
+#endif
 
-void main()
+//Up to 4 LUTs in consecutive slots (30 - 33)
+layout (binding = 30) uniform sampler3D u_TexColorGrade[4];
+
+//How many LUTs are bound
+uniform int u_LutCount = 1;
+//How much each LUT contributes, adds up to 1
+uniform vec4 u_LutWeights = vec4(1.0, 0.0, 0.0, 0.0);
+//Texels along each axis of each LUT (LUT_3D_SIZE)
+uniform vec4 u_LutSizes = vec4(64.0);
+//Input range each LUT was authored for
+uniform vec3 u_DomainMin[4] = vec3[4](vec3(0.0), vec3(0.0), vec3(0.0), vec3(0.0));
+uniform vec3 u_DomainMax[4] = vec3[4](vec3(1.0), vec3(1.0), vec3(1.0), vec3(1.0));
+
+vec3 Grade(int index, vec3 color)
 {
-	vec4 textureColor = texture(u_FinishedFrame, inUV);
+	//Map the colour into the LUT domain, then onto texel centres
+	vec3 domainColor = clamp((color - u_DomainMin[index]) / (u_DomainMax[index] - u_DomainMin[index]), 0.0, 1.0);
+	vec3 scale = vec3((u_LutSizes[index] - 1.0) / u_LutSizes[index]);
+	vec3 offset = vec3(1.0 / (2.0 * u_LutSizes[index]));
 
-	vec3 scale = vec3((64.0 - 1.0) / 64.0);
-	vec3 offset = vec3(1.0 / (2.0 * 64.0));
+	return texture(u_TexColorGrade[index], scale * domainColor + offset).rgb;
+}
 
-	frag_color.rgb = texture(u_TexColorGrade, scale * textureColor.rgb + offset).rgb;
-	frag_color.a = textureColor.a;
+vec4 ColorCorrect(vec4 textureColor)
+{
+	//Nothing bound, leave the colour as it is
+	vec3 graded = u_LutCount == 0 ? textureColor.rgb : vec3(0.0);
+	for (int i = 0; i < 4; i++)
+	{
+		if (i < u_LutCount)
+			graded += Grade(i, textureColor.rgb) * u_LutWeights[i];
+	}
 
-}
\ No newline at end of file
+	return vec4(graded, textureColor.a);
+}
+
+#ifndef FUSED_POST
+void main()
+{
+	frag_color = ColorCorrect(texture(u_FinishedFrame, inUV));
+}
+#endif
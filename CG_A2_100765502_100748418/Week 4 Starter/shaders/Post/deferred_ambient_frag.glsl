@@ -0,0 +1,81 @@
+#version 420
+
+layout(location = 0) in vec2 inUV;
+
+out vec4 frag_color;
+
+//G-buffer
+layout (binding = 0) uniform sampler2D s_AlbedoSpec;
+layout (binding = 1) uniform sampler2D s_NormalShininess;
+layout (binding = 2) uniform sampler2D s_Depth;
+
+//Camera and timing, u_InverseViewProjection turns depth back into a world position (see ShaderBlocks.h)
+layout(std140, binding = 0) uniform FrameData {
+    mat4  u_View;
+    mat4  u_Projection;
+    mat4  u_ViewProjection;
+    mat4  u_InverseViewProjection;
+    mat4  u_SkyboxMatrix;
+    vec3  u_CamPos;
+    float u_Time;
+};
+
+//Scene light and ambient, shared by every lit shader (see ShaderBlocks.h)
+layout(std140, binding = 1) uniform SceneLighting {
+    vec3  u_LightPos;
+    float u_AmbientLightStrength;
+    vec3  u_LightCol;
+    float u_SpecularLightStrength;
+    vec3  u_AmbientCol;
+    float u_AmbientStrength;
+    float u_LightAttenuationConstant;
+    float u_LightAttenuationLinear;
+    float u_LightAttenuationQuadratic;
+};
+
+//Part of the G-buffer that was rendered to (see passthrough_vert)
+uniform vec2 u_UVScale = vec2(1.0);
+
+vec3 ReconstructPosition(float depth)
+{
+    //Undo the UV scale to get back to the quad's 0 - 1 range, then into NDC
+    vec2 ndc = (inUV / u_UVScale) * 2.0 - 1.0;
+    vec4 world = u_InverseViewProjection * vec4(ndc, depth * 2.0 - 1.0, 1.0);
+    return world.xyz / world.w;
+}
+
+void main() {
+    float depth = texture(s_Depth, inUV).r;
+    //Nothing was drawn here
+    if (depth >= 1.0)
+        discard;
+
+    vec4 albedoSpec = texture(s_AlbedoSpec, inUV);
+    vec4 normalShininess = texture(s_NormalShininess, inUV);
+
+    vec3 inPos = ReconstructPosition(depth);
+
+    vec3 ambient = ((u_AmbientLightStrength * u_LightCol) + (u_AmbientCol * u_AmbientStrength));
+
+    // Diffuse
+    vec3 N = normalize(normalShininess.xyz);
+    vec3 lightDir = normalize(u_LightPos - inPos);
+
+    float dif = max(dot(N, lightDir), 0.0);
+    vec3 diffuse = dif * u_LightCol;
+
+    //Attenuation
+    float dist = length(u_LightPos - inPos);
+    float attenuation = 1.0f / (
+        u_LightAttenuationConstant + 
+        u_LightAttenuationLinear * dist +
+        u_LightAttenuationQuadratic * dist * dist);
+
+    // Specular
+    vec3 camDir = normalize(u_CamPos - inPos);
+    vec3 reflectDir = reflect(-lightDir, N);
+    float spec = pow(max(dot(camDir, reflectDir), 0.0), normalShininess.a);
+    vec3 specular = u_SpecularLightStrength * albedoSpec.a * spec * u_LightCol;
+
+    frag_color = vec4(((ambient + diffuse + specular) * attenuation) * albedoSpec.rgb, 1.0);
+}
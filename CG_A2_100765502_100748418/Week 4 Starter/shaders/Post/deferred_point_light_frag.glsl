@@ -0,0 +1,83 @@
+#version 420
+
+layout(location = 0) in vec2 inUV;
+
+out vec4 frag_color;
+
+//G-buffer
+layout (binding = 0) uniform sampler2D s_AlbedoSpec;
+layout (binding = 1) uniform sampler2D s_NormalShininess;
+layout (binding = 2) uniform sampler2D s_Depth;
+
+//Camera and timing, u_InverseViewProjection turns depth back into a world position (see ShaderBlocks.h)
+layout(std140, binding = 0) uniform FrameData {
+    mat4  u_View;
+    mat4  u_Projection;
+    mat4  u_ViewProjection;
+    mat4  u_InverseViewProjection;
+    mat4  u_SkyboxMatrix;
+    vec3  u_CamPos;
+    float u_Time;
+};
+
+//Scene light and ambient, only u_SpecularLightStrength is used here (see ShaderBlocks.h)
+layout(std140, binding = 1) uniform SceneLighting {
+    vec3  u_LightPos;
+    float u_AmbientLightStrength;
+    vec3  u_LightCol;
+    float u_SpecularLightStrength;
+    vec3  u_AmbientCol;
+    float u_AmbientStrength;
+    float u_LightAttenuationConstant;
+    float u_LightAttenuationLinear;
+    float u_LightAttenuationQuadratic;
+};
+
+//Part of the G-buffer that was rendered to (see passthrough_vert)
+uniform vec2 u_UVScale = vec2(1.0);
+
+//The light this pass adds, only drawn inside the light's screen rectangle
+uniform vec3  u_PointLightPos;
+uniform vec3  u_PointLightCol;
+uniform float u_PointLightRadius;
+
+vec3 ReconstructPosition(float depth)
+{
+    //Undo the UV scale to get back to the quad's 0 - 1 range, then into NDC
+    vec2 ndc = (inUV / u_UVScale) * 2.0 - 1.0;
+    vec4 world = u_InverseViewProjection * vec4(ndc, depth * 2.0 - 1.0, 1.0);
+    return world.xyz / world.w;
+}
+
+void main() {
+    float depth = texture(s_Depth, inUV).r;
+    if (depth >= 1.0)
+        discard;
+
+    vec3 inPos = ReconstructPosition(depth);
+    vec3 toLight = u_PointLightPos - inPos;
+    float dist = length(toLight);
+    //Outside the light's reach
+    if (dist >= u_PointLightRadius)
+        discard;
+
+    vec4 albedoSpec = texture(s_AlbedoSpec, inUV);
+    vec4 normalShininess = texture(s_NormalShininess, inUV);
+
+    vec3 N = normalize(normalShininess.xyz);
+    vec3 lightDir = toLight / dist;
+
+    float dif = max(dot(N, lightDir), 0.0);
+
+    vec3 camDir = normalize(u_CamPos - inPos);
+    vec3 reflectDir = reflect(-lightDir, N);
+    float spec = pow(max(dot(camDir, reflectDir), 0.0), normalShininess.a);
+
+    //Inverse square falloff, windowed so it reaches zero at the radius
+    float window = clamp(1.0 - pow(dist / u_PointLightRadius, 4.0), 0.0, 1.0);
+    float attenuation = (window * window) / (dist * dist + 1.0);
+
+    //Same as ClusterLighting in frag_phong, tinted by the albedo like the forward pass
+    vec3 light = (dif + u_SpecularLightStrength * albedoSpec.a * spec) * u_PointLightCol * attenuation;
+    frag_color = vec4(light * albedoSpec.rgb, 1.0);
+}
@@ -1,21 +1,29 @@
 #version 420
 
+//FUSED_POST is defined when this is pasted into a fused post shader,
+//which declares the inputs and main itself
+#ifndef FUSED_POST
 layout(location = 0) in vec2 inUV;
 
 out vec4 frag_color;
 
 layout (binding = 0) uniform sampler2D s_screenTex;
+#endif
 
 //Affects how greyscale
 //Lower the number, closer we are to regular
-uniform float u_Intensity = 1.0;
+uniform float u_GreyscaleIntensity = 1.0;
 
-void main() 
+vec4 Greyscale(vec4 source)
 {
-	vec4 source = texture(s_screenTex, inUV);
-
 	float luminence = 0.2989 * source.r + 0.587 * source.g + 0.114 * source.b;
 
-	frag_color.rgb = mix(source.rgb, vec3(luminence), u_Intensity);
-    frag_color.a = source.a;
-}#
\ No newline at end of file
+	return vec4(mix(source.rgb, vec3(luminence), u_GreyscaleIntensity), source.a);
+}
+
+#ifndef FUSED_POST
+void main() 
+{
+	frag_color = Greyscale(texture(s_screenTex, inUV));
+}
+#endif
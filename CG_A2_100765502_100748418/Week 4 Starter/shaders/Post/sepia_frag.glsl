@@ -1,24 +1,32 @@
 #version 420
 
+//FUSED_POST is defined when this is pasted into a fused post shader,
+//which declares the inputs and main itself
+#ifndef FUSED_POST
 layout(location = 0) in vec2 inUV;
 
 out vec4 frag_color;
 
 layout (binding = 0) uniform sampler2D s_screenTex;
+#endif
 
 //Intensity of the sepia effect
 //Lower the number, closerto regular color
-uniform float u_Intensity = 0.6;
+uniform float u_SepiaIntensity = 0.6;
 
-void main() 
+vec4 Sepia(vec4 source)
 {
-	vec4 source = texture(s_screenTex, inUV);
-
 	vec3 sepiaColor;
 	sepiaColor.r = ((source.r * 0.393) + (source.g * 0.769) + (source.b * 0.189));
 	sepiaColor.g = ((source.r * 0.349) + (source.g * 0.686) + (source.b * 0.168));
 	sepiaColor.b = ((source.r * 0.272) + (source.g * 0.534) + (source.b * 0.131));
 
-	frag_color.rgb = mix(source.rgb, sepiaColor.rgb, u_Intensity);
-	frag_color.a = source.a;
-}
\ No newline at end of file
+	return vec4(mix(source.rgb, sepiaColor.rgb, u_SepiaIntensity), source.a);
+}
+
+#ifndef FUSED_POST
+void main() 
+{
+	frag_color = Sepia(texture(s_screenTex, inUV));
+}
+#endif
@@ -0,0 +1,23 @@
+#version 410
+
+layout(location = 0) in vec3 inPos;
+layout(location = 1) in vec3 inColor;
+layout(location = 2) in vec3 inNormal;
+layout(location = 3) in vec2 inUV;
+
+uniform sampler2D s_Diffuse;
+uniform sampler2D s_Specular;
+
+uniform float u_Shininess;
+
+//Colour in rgb, specular strength in a
+layout(location = 0) out vec4 outAlbedoSpec;
+//World space normal in rgb, shininess in a
+layout(location = 1) out vec4 outNormalShininess;
+
+void main() {
+    vec4 textureColor = texture(s_Diffuse, inUV);
+
+    outAlbedoSpec = vec4(inColor * textureColor.rgb, texture(s_Specular, inUV).x);
+    outNormalShininess = vec4(normalize(inNormal), u_Shininess);
+}
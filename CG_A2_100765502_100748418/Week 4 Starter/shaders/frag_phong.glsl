@@ -1,4 +1,4 @@
-#version 410
+#version 420
 
 layout(location = 0) in vec3 inPos;
 layout(location = 1) in vec3 inColor;
@@ -8,23 +8,75 @@ layout(location = 3) in vec2 inUV;
 uniform sampler2D s_Diffuse;
 uniform sampler2D s_Specular;
 
-uniform vec3  u_AmbientCol;
-uniform float u_AmbientStrength;
-
-uniform vec3  u_LightPos;
-uniform vec3  u_LightCol;
-uniform float u_AmbientLightStrength;
-uniform float u_SpecularLightStrength;
 uniform float u_Shininess;
 uniform float u_TextureMix;
-uniform vec3  u_CamPos;
 
-uniform float u_LightAttenuationConstant;
-uniform float u_LightAttenuationLinear;
-uniform float u_LightAttenuationQuadratic;
+//Camera and timing, shared by every scene shader (see ShaderBlocks.h)
+layout(std140, binding = 0) uniform FrameData {
+    mat4  u_View;
+    mat4  u_Projection;
+    mat4  u_ViewProjection;
+    mat4  u_InverseViewProjection;
+    mat4  u_SkyboxMatrix;
+    vec3  u_CamPos;
+    float u_Time;
+};
+
+//Scene light and ambient, shared by every lit shader (see ShaderBlocks.h)
+layout(std140, binding = 1) uniform SceneLighting {
+    vec3  u_LightPos;
+    float u_AmbientLightStrength;
+    vec3  u_LightCol;
+    float u_SpecularLightStrength;
+    vec3  u_AmbientCol;
+    float u_AmbientStrength;
+    float u_LightAttenuationConstant;
+    float u_LightAttenuationLinear;
+    float u_LightAttenuationQuadratic;
+};
+
+//Clustered point lights (see LightClusters)
+layout(binding = 20) uniform samplerBuffer  s_ClusterLights;
+layout(binding = 21) uniform usamplerBuffer s_ClusterGrid;
+layout(binding = 22) uniform usamplerBuffer s_ClusterIndices;
+uniform ivec3 u_ClusterDims;
+uniform vec2  u_ClusterTileScale;
+uniform vec2  u_ClusterDepthParams;
 
 out vec4 frag_color;
 
+//Diffuse and specular from the point lights in this fragment's cluster
+vec3 ClusterLighting(vec3 N, vec3 camDir, float texSpec) {
+    float depth = -(u_View * vec4(inPos, 1.0)).z;
+    ivec3 cluster = ivec3(ivec2(gl_FragCoord.xy * u_ClusterTileScale), int(log(max(depth, 1e-4)) * u_ClusterDepthParams.x + u_ClusterDepthParams.y));
+    cluster = clamp(cluster, ivec3(0), u_ClusterDims - 1);
+
+    uvec2 grid = texelFetch(s_ClusterGrid, (cluster.z * u_ClusterDims.y + cluster.y) * u_ClusterDims.x + cluster.x).xy;
+
+    vec3 result = vec3(0.0);
+    for (uint i = 0u; i < grid.y; i++) {
+        int light = int(texelFetch(s_ClusterIndices, int(grid.x + i)).x);
+        vec4 posRadius = texelFetch(s_ClusterLights, light * 2);
+        vec3 color = texelFetch(s_ClusterLights, light * 2 + 1).rgb;
+
+        vec3 toLight = posRadius.xyz - inPos;
+        float dist = length(toLight);
+        if (dist >= posRadius.w)
+            continue;
+        vec3 lightDir = toLight / dist;
+
+        float dif = max(dot(N, lightDir), 0.0);
+        vec3 reflectDir = reflect(-lightDir, N);
+        float spec = pow(max(dot(camDir, reflectDir), 0.0), u_Shininess);
+        //Inverse square falloff, windowed so it reaches zero at the radius (same as the deferred path)
+        float window = clamp(1.0 - pow(dist / posRadius.w, 4.0), 0.0, 1.0);
+        float attenuation = (window * window) / (dist * dist + 1.0);
+
+        result += (dif + u_SpecularLightStrength * texSpec * spec) * color * attenuation;
+    }
+    return result;
+}
+
 void main() {
     // Lecture 5
     vec3 ambient = ((u_AmbientLightStrength * u_LightCol) + (u_AmbientCol * u_AmbientStrength));
@@ -57,6 +109,7 @@ void main() {
     vec4 textureColor = mix(textureColor1, textureColor1, u_TextureMix);
 
     vec3 result = ((ambient + diffuse + specular)* attenuation) * inColor * textureColor.rgb;
+    result += ClusterLighting(N, camDir, texSpec) * inColor * textureColor.rgb;
 
     frag_color = vec4(result, textureColor.a);
 }
\ No newline at end of file
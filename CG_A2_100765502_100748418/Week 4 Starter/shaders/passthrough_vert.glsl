@@ -5,8 +5,12 @@ layout (location = 1) in vec2 inUV;
 
 layout(location = 0) out vec2 outUV;
 
+//Part of the input texture that was rendered to
+//*Render targets are allocated in size buckets so this can be less than 1
+uniform vec2 u_UVScale = vec2(1.0);
+
 void main()
 { 
-	outUV = inUV;
+	outUV = inUV * u_UVScale;
 	gl_Position = vec4(inPosition, 1.0);
-}
\ No newline at end of file
+}
@@ -1,10 +1,19 @@
-#version 410
+#version 420
 
 layout(location = 0) in vec3 inPosition;
 
 layout(location = 0) out vec3 outNormal;
 
-uniform mat4 u_SkyboxMatrix;
+//Camera and timing, shared by every scene shader (see ShaderBlocks.h)
+layout(std140, binding = 0) uniform FrameData {
+    mat4  u_View;
+    mat4  u_Projection;
+    mat4  u_ViewProjection;
+    mat4  u_InverseViewProjection;
+    mat4  u_SkyboxMatrix;
+    vec3  u_CamPos;
+    float u_Time;
+};
 uniform mat3 u_EnvironmentRotation;
 
 void main() {
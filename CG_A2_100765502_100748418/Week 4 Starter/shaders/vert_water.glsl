@@ -1,4 +1,4 @@
-#version 410
+#version 430
 
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inColor;
@@ -10,35 +10,51 @@ layout(location = 1) out vec3 outColor;
 layout(location = 2) out vec3 outNormal;
 layout(location = 3) out vec2 outUV;
 
-uniform mat4 u_ModelViewProjection;
-uniform mat4 u_View;
-uniform mat4 u_Model;
-uniform mat3 u_NormalMatrix;
-uniform vec3 u_LightPos;
+//Per draw matrices written by DrawDataBuffer, indexed by the draw id (see ShaderBlocks.h)
+struct DrawData {
+	mat4 ModelViewProjection;
+	mat4 Model;
+	mat4 NormalMatrix;
+};
+layout(std430, binding = 0) readonly buffer DrawDataBlock {
+	DrawData u_Draws[];
+};
+layout(location = 8) in uint inDrawId;
 
-uniform float time;
 uniform float isWavy;
 
+//Camera and timing, shared by every scene shader (see ShaderBlocks.h)
+layout(std140, binding = 0) uniform FrameData {
+	mat4  u_View;
+	mat4  u_Projection;
+	mat4  u_ViewProjection;
+	mat4  u_InverseViewProjection;
+	mat4  u_SkyboxMatrix;
+	vec3  u_CamPos;
+	float u_Time;
+};
+
 void main() {
 
+	DrawData draw = u_Draws[inDrawId];
 	vec3 vert = inPosition;
 
-	vert.z = sin(vert.x * 3.0 + time * 0.1) * .5;
+	vert.z = sin(vert.x * 3.0 + u_Time * 0.1) * .5;
 
 	if(isWavy == 1)
 	{
-		gl_Position = u_ModelViewProjection * vec4(vert, 1.0);
-		outPos = (u_Model * vec4(vert, 1.0)).xyz;
+		gl_Position = draw.ModelViewProjection * vec4(vert, 1.0);
+		outPos = (draw.Model * vec4(vert, 1.0)).xyz;
 	}
 	else
 	{
-		gl_Position = u_ModelViewProjection * vec4(inPosition, 1.0);
-		outPos = (u_Model * vec4(inPosition, 1.0)).xyz;
+		gl_Position = draw.ModelViewProjection * vec4(inPosition, 1.0);
+		outPos = (draw.Model * vec4(inPosition, 1.0)).xyz;
 	}
 
 
 	// Normals
-	outNormal = u_NormalMatrix * inNormal;
+	outNormal = mat3(draw.NormalMatrix) * inNormal;
 
 	// Pass our UV coords to the fragment shader
 	outUV = inUV;
@@ -1,4 +1,4 @@
-#version 410
+#version 430
 
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inColor;
@@ -10,23 +10,55 @@ layout(location = 1) out vec3 outColor;
 layout(location = 2) out vec3 outNormal;
 layout(location = 3) out vec2 outUV;
 
-uniform mat4 u_ModelViewProjection;
-uniform mat4 u_View;
-uniform mat4 u_Model;
-uniform mat3 u_NormalMatrix;
-uniform vec3 u_LightPos;
+//Per instance model matrix (see InstancedRenderer), takes up locations 4 - 7
+layout(location = 4) in mat4 inInstanceModel;
 
+//Per draw matrices written by DrawDataBuffer, indexed by the draw id (see ShaderBlocks.h)
+struct DrawData {
+	mat4 ModelViewProjection;
+	mat4 Model;
+	mat4 NormalMatrix;
+};
+layout(std430, binding = 0) readonly buffer DrawDataBlock {
+	DrawData u_Draws[];
+};
+layout(location = 8) in uint inDrawId;
+//Use inInstanceModel instead of the draw data
+uniform bool u_Instanced = false;
+
+//Camera and timing, shared by every scene shader (see ShaderBlocks.h)
+layout(std140, binding = 0) uniform FrameData {
+	mat4  u_View;
+	mat4  u_Projection;
+	mat4  u_ViewProjection;
+	mat4  u_InverseViewProjection;
+	mat4  u_SkyboxMatrix;
+	vec3  u_CamPos;
+	float u_Time;
+};
 
 void main() {
 
-	gl_Position = u_ModelViewProjection * vec4(inPosition, 1.0);
+	if (u_Instanced)
+	{
+		vec4 worldPos = inInstanceModel * vec4(inPosition, 1.0);
+		gl_Position = u_ViewProjection * worldPos;
+		outPos = worldPos.xyz;
+		// Spawns are only moved and rotated, so the model matrix works for normals too
+		outNormal = mat3(inInstanceModel) * inNormal;
+	}
+	else
+	{
+		DrawData draw = u_Draws[inDrawId];
+		gl_Position = draw.ModelViewProjection * vec4(inPosition, 1.0);
 
-	// Lecture 5
-	// Pass vertex pos in world space to frag shader
-	outPos = (u_Model * vec4(inPosition, 1.0)).xyz;
+		// Lecture 5
+		// Pass vertex pos in world space to frag shader
+		outPos = (draw.Model * vec4(inPosition, 1.0)).xyz;
 
-	// Normals
-	outNormal = u_NormalMatrix * inNormal;
+		// Normals
+		outNormal = mat3(draw.NormalMatrix) * inNormal;
+	}
 
 	// Pass our UV coords to the fragment shader
 	outUV = inUV;
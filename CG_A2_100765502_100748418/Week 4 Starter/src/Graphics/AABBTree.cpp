@@ -0,0 +1,330 @@
+#include "AABBTree.h"
+
+#include <algorithm>
+#include <cmath>
+
+AABBTree::AABBTree(float margin)
+	: _margin(margin)
+{
+}
+
+int AABBTree::CreateProxy(const AABB& box, uint32_t userData)
+{
+	int proxy = AllocateNode();
+	_nodes[proxy].Box = AABB(box.Min - glm::vec3(_margin), box.Max + glm::vec3(_margin));
+	_nodes[proxy].UserData = userData;
+	_nodes[proxy].Height = 0;
+	InsertLeaf(proxy);
+	_proxyCount++;
+	return proxy;
+}
+
+void AABBTree::DestroyProxy(int proxy)
+{
+	RemoveLeaf(proxy);
+	FreeNode(proxy);
+	_proxyCount--;
+}
+
+bool AABBTree::MoveProxy(int proxy, const AABB& box)
+{
+	//Still inside its fat box, nothing to do
+	if (_nodes[proxy].Box.Contains(box))
+		return false;
+
+	RemoveLeaf(proxy);
+	_nodes[proxy].Box = AABB(box.Min - glm::vec3(_margin), box.Max + glm::vec3(_margin));
+	InsertLeaf(proxy);
+	return true;
+}
+
+void AABBTree::Clear()
+{
+	_nodes.clear();
+	_root = NULL_NODE;
+	_freeList = NULL_NODE;
+	_proxyCount = 0;
+}
+
+void AABBTree::QueryFrustum(const Frustum& frustum, const std::function<void(uint32_t)>& callback) const
+{
+	Query([&](const AABB& box) { return frustum.Intersects(box); }, callback);
+}
+
+void AABBTree::QuerySphere(const BoundingSphere& sphere, const std::function<void(uint32_t)>& callback) const
+{
+	Query([&](const AABB& box) { return sphere.Overlaps(box); }, callback);
+}
+
+void AABBTree::QueryBox(const AABB& box, const std::function<void(uint32_t)>& callback) const
+{
+	Query([&](const AABB& nodeBox) { return box.Overlaps(nodeBox); }, callback);
+}
+
+void AABBTree::RayCast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, const std::function<float(uint32_t, float)>& callback) const
+{
+	if (_root == NULL_NODE)
+		return;
+
+	glm::vec3 inverseDirection = 1.0f / direction;
+
+	std::vector<int> stack;
+	stack.push_back(_root);
+	while (!stack.empty())
+	{
+		int index = stack.back();
+		stack.pop_back();
+
+		const Node& node = _nodes[index];
+		float distance;
+		if (!node.Box.IntersectsRay(origin, inverseDirection, maxDistance, distance))
+			continue;
+
+		if (node.IsLeaf())
+		{
+			maxDistance = callback(node.UserData, distance);
+		}
+		else
+		{
+			stack.push_back(node.Left);
+			stack.push_back(node.Right);
+		}
+	}
+}
+
+const AABB& AABBTree::GetFatBox(int proxy) const
+{
+	return _nodes[proxy].Box;
+}
+
+uint32_t AABBTree::GetUserData(int proxy) const
+{
+	return _nodes[proxy].UserData;
+}
+
+int AABBTree::GetProxyCount() const
+{
+	return _proxyCount;
+}
+
+int AABBTree::GetHeight() const
+{
+	return _root == NULL_NODE ? 0 : _nodes[_root].Height;
+}
+
+int AABBTree::AllocateNode()
+{
+	if (_freeList == NULL_NODE)
+	{
+		_nodes.emplace_back();
+		return int(_nodes.size()) - 1;
+	}
+
+	int node = _freeList;
+	_freeList = _nodes[node].Parent;
+	_nodes[node] = Node();
+	return node;
+}
+
+void AABBTree::FreeNode(int node)
+{
+	_nodes[node].Parent = _freeList;
+	_nodes[node].Height = -1;
+	_freeList = node;
+}
+
+void AABBTree::InsertLeaf(int leaf)
+{
+	_nodes[leaf].Parent = NULL_NODE;
+	if (_root == NULL_NODE)
+	{
+		_root = leaf;
+		return;
+	}
+
+	//Walk down to the sibling that makes the tree grow the least (surface area heuristic)
+	AABB leafBox = _nodes[leaf].Box;
+	int index = _root;
+	while (!_nodes[index].IsLeaf())
+	{
+		const Node& node = _nodes[index];
+
+		AABB combined = node.Box;
+		combined.Expand(leafBox);
+		float area = node.Box.GetSurfaceArea();
+		float combinedArea = combined.GetSurfaceArea();
+
+		//Cost of making a new parent for this node and the leaf
+		float cost = 2.0f * combinedArea;
+		//Minimum cost of pushing the leaf further down
+		float inheritedCost = 2.0f * (combinedArea - area);
+
+		float childCost[2];
+		int children[2] = { node.Left, node.Right };
+		for (int i = 0; i < 2; i++)
+		{
+			const Node& child = _nodes[children[i]];
+			AABB childCombined = child.Box;
+			childCombined.Expand(leafBox);
+			if (child.IsLeaf())
+				childCost[i] = childCombined.GetSurfaceArea() + inheritedCost;
+			else
+				childCost[i] = childCombined.GetSurfaceArea() - child.Box.GetSurfaceArea() + inheritedCost;
+		}
+
+		if (cost < childCost[0] && cost < childCost[1])
+			break;
+
+		index = childCost[0] < childCost[1] ? children[0] : children[1];
+	}
+
+	//Put a new parent above the sibling holding both
+	int sibling = index;
+	int oldParent = _nodes[sibling].Parent;
+	int newParent = AllocateNode();
+	_nodes[newParent].Parent = oldParent;
+	_nodes[newParent].Box = _nodes[sibling].Box;
+	_nodes[newParent].Box.Expand(leafBox);
+	_nodes[newParent].Height = _nodes[sibling].Height + 1;
+	_nodes[newParent].Left = sibling;
+	_nodes[newParent].Right = leaf;
+	_nodes[sibling].Parent = newParent;
+	_nodes[leaf].Parent = newParent;
+
+	if (oldParent == NULL_NODE)
+		_root = newParent;
+	else if (_nodes[oldParent].Left == sibling)
+		_nodes[oldParent].Left = newParent;
+	else
+		_nodes[oldParent].Right = newParent;
+
+	RefitUpwards(_nodes[leaf].Parent);
+}
+
+void AABBTree::RemoveLeaf(int leaf)
+{
+	if (leaf == _root)
+	{
+		_root = NULL_NODE;
+		return;
+	}
+
+	//The sibling takes the parent's place
+	int parent = _nodes[leaf].Parent;
+	int grandParent = _nodes[parent].Parent;
+	int sibling = _nodes[parent].Left == leaf ? _nodes[parent].Right : _nodes[parent].Left;
+
+	if (grandParent == NULL_NODE)
+	{
+		_root = sibling;
+		_nodes[sibling].Parent = NULL_NODE;
+		FreeNode(parent);
+		return;
+	}
+
+	if (_nodes[grandParent].Left == parent)
+		_nodes[grandParent].Left = sibling;
+	else
+		_nodes[grandParent].Right = sibling;
+	_nodes[sibling].Parent = grandParent;
+	FreeNode(parent);
+
+	RefitUpwards(grandParent);
+}
+
+void AABBTree::RefitUpwards(int node)
+{
+	while (node != NULL_NODE)
+	{
+		node = Balance(node);
+
+		Node& current = _nodes[node];
+		const Node& left = _nodes[current.Left];
+		const Node& right = _nodes[current.Right];
+		current.Height = 1 + std::max(left.Height, right.Height);
+		current.Box = left.Box;
+		current.Box.Expand(right.Box);
+
+		node = current.Parent;
+	}
+}
+
+int AABBTree::Balance(int a)
+{
+	Node& nodeA = _nodes[a];
+	if (nodeA.IsLeaf() || nodeA.Height < 2)
+		return a;
+
+	int b = nodeA.Left;
+	int c = nodeA.Right;
+	int balance = _nodes[c].Height - _nodes[b].Height;
+	if (balance >= -1 && balance <= 1)
+		return a;
+
+	//Promote the taller child, its shorter child moves down to a
+	int up = balance > 1 ? c : b;
+	int stay = balance > 1 ? b : c;
+	Node& nodeUp = _nodes[up];
+	int f = nodeUp.Left;
+	int g = nodeUp.Right;
+
+	//The taller child takes a's place
+	nodeUp.Left = a;
+	nodeUp.Parent = nodeA.Parent;
+	nodeA.Parent = up;
+	if (nodeUp.Parent == NULL_NODE)
+		_root = up;
+	else if (_nodes[nodeUp.Parent].Left == a)
+		_nodes[nodeUp.Parent].Left = up;
+	else
+		_nodes[nodeUp.Parent].Right = up;
+
+	//The taller grandchild stays with up, the shorter one goes to a
+	int keep = _nodes[f].Height > _nodes[g].Height ? f : g;
+	int give = keep == f ? g : f;
+	nodeUp.Right = keep;
+	if (balance > 1)
+		nodeA.Right = give;
+	else
+		nodeA.Left = give;
+	_nodes[give].Parent = a;
+
+	nodeA.Box = _nodes[stay].Box;
+	nodeA.Box.Expand(_nodes[give].Box);
+	nodeA.Height = 1 + std::max(_nodes[stay].Height, _nodes[give].Height);
+
+	nodeUp.Box = nodeA.Box;
+	nodeUp.Box.Expand(_nodes[keep].Box);
+	nodeUp.Height = 1 + std::max(nodeA.Height, _nodes[keep].Height);
+
+	return up;
+}
+
+template <typename Test>
+void AABBTree::Query(Test test, const std::function<void(uint32_t)>& callback) const
+{
+	if (_root == NULL_NODE)
+		return;
+
+	std::vector<int> stack;
+	stack.push_back(_root);
+	while (!stack.empty())
+	{
+		int index = stack.back();
+		stack.pop_back();
+
+		const Node& node = _nodes[index];
+		if (!test(node.Box))
+			continue;
+
+		if (node.IsLeaf())
+		{
+			callback(node.UserData);
+		}
+		else
+		{
+			stack.push_back(node.Left);
+			stack.push_back(node.Right);
+		}
+	}
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <functional>
+
+#include "Graphics/Bounds.h"
+
+//Dynamic bounding volume hierarchy
+//*Every proxy is a leaf holding a slightly enlarged ("fat") box, so small movements don't touch the tree at all
+//*Leaves are inserted next to whichever node grows the least, and rotations keep the tree balanced
+class AABBTree
+{
+public:
+	static const int NULL_NODE = -1;
+
+	//How much each side of a leaf's box is grown by
+	explicit AABBTree(float margin = 0.1f);
+
+	//Adds a box to the tree, returns the proxy used to move or remove it
+	int CreateProxy(const AABB& box, uint32_t userData);
+	void DestroyProxy(int proxy);
+	//Updates a proxy's box, only reinserts it if it left its fat box
+	//*Returns true if the tree changed
+	bool MoveProxy(int proxy, const AABB& box);
+
+	//Removes everything
+	void Clear();
+
+	//Queries, the callback gets the user data of each proxy whose fat box passes
+	void QueryFrustum(const Frustum& frustum, const std::function<void(uint32_t)>& callback) const;
+	void QuerySphere(const BoundingSphere& sphere, const std::function<void(uint32_t)>& callback) const;
+	void QueryBox(const AABB& box, const std::function<void(uint32_t)>& callback) const;
+	//Calls back with each proxy the ray hits and the distance it enters its box at
+	//*The callback returns the new max distance (return the given distance to only find closer hits, or maxDistance to find them all)
+	void RayCast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, const std::function<float(uint32_t, float)>& callback) const;
+
+	//Getters
+	const AABB& GetFatBox(int proxy) const;
+	uint32_t GetUserData(int proxy) const;
+	int GetProxyCount() const;
+	int GetHeight() const;
+
+private:
+	struct Node
+	{
+		AABB Box;
+		//Parent node, or the next free node while it's unused
+		int Parent = NULL_NODE;
+		int Left = NULL_NODE;
+		int Right = NULL_NODE;
+		//Leaves are 0, unused nodes are -1
+		int Height = -1;
+		uint32_t UserData = 0;
+
+		bool IsLeaf() const { return Left == NULL_NODE; }
+	};
+
+	int AllocateNode();
+	void FreeNode(int node);
+
+	void InsertLeaf(int leaf);
+	void RemoveLeaf(int leaf);
+	//Rotates around node if its children's heights are more than one apart, returns the new top of the subtree
+	int Balance(int node);
+	//Fixes the boxes and heights from node up to the root
+	void RefitUpwards(int node);
+
+	//Walks every node whose box passes the test
+	template <typename Test>
+	void Query(Test test, const std::function<void(uint32_t)>& callback) const;
+
+	std::vector<Node> _nodes;
+	int _root = NULL_NODE;
+	int _freeList = NULL_NODE;
+	int _proxyCount = 0;
+	float _margin;
+};
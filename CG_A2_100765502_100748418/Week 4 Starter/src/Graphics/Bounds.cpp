@@ -0,0 +1,206 @@
+#include "Bounds.h"
+
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__SSE2__)
+#define BOUNDS_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+AABB::AABB()
+{
+}
+
+AABB::AABB(const glm::vec3& min, const glm::vec3& max)
+	: Min(min), Max(max)
+{
+}
+
+void AABB::Expand(const glm::vec3& point)
+{
+	Min = glm::min(Min, point);
+	Max = glm::max(Max, point);
+}
+
+void AABB::Expand(const AABB& other)
+{
+	Min = glm::min(Min, other.Min);
+	Max = glm::max(Max, other.Max);
+}
+
+AABB AABB::Transformed(const glm::mat4& transform) const
+{
+	if (!IsValid())
+		return *this;
+
+	//Move the center, then work out how far the rotated extents reach on each axis
+	glm::vec3 center = glm::vec3(transform * glm::vec4(GetCenter(), 1.0f));
+	glm::vec3 extents = GetExtents();
+	glm::vec3 newExtents = glm::vec3(0.0f);
+	for (int i = 0; i < 3; i++)
+		newExtents += glm::abs(glm::vec3(transform[i])) * extents[i];
+
+	return AABB(center - newExtents, center + newExtents);
+}
+
+bool AABB::Overlaps(const AABB& other) const
+{
+	return Min.x <= other.Max.x && Max.x >= other.Min.x &&
+		Min.y <= other.Max.y && Max.y >= other.Min.y &&
+		Min.z <= other.Max.z && Max.z >= other.Min.z;
+}
+
+bool AABB::Contains(const AABB& other) const
+{
+	return Min.x <= other.Min.x && Min.y <= other.Min.y && Min.z <= other.Min.z &&
+		Max.x >= other.Max.x && Max.y >= other.Max.y && Max.z >= other.Max.z;
+}
+
+bool AABB::IntersectsRay(const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance, float& distance) const
+{
+	//Slab test, where the ray enters and leaves each pair of planes
+	glm::vec3 t0 = (Min - origin) * inverseDirection;
+	glm::vec3 t1 = (Max - origin) * inverseDirection;
+	glm::vec3 tNear = glm::min(t0, t1);
+	glm::vec3 tFar = glm::max(t0, t1);
+
+	float enter = glm::max(glm::max(tNear.x, tNear.y), glm::max(tNear.z, 0.0f));
+	float exit = glm::min(glm::min(tFar.x, tFar.y), glm::min(tFar.z, maxDistance));
+	if (enter > exit)
+		return false;
+
+	distance = enter;
+	return true;
+}
+
+glm::vec3 AABB::GetCenter() const
+{
+	return (Min + Max) * 0.5f;
+}
+
+glm::vec3 AABB::GetExtents() const
+{
+	return (Max - Min) * 0.5f;
+}
+
+bool AABB::IsValid() const
+{
+	return Min.x <= Max.x && Min.y <= Max.y && Min.z <= Max.z;
+}
+
+float AABB::GetSurfaceArea() const
+{
+	glm::vec3 size = Max - Min;
+	return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+
+BoundingSphere::BoundingSphere()
+{
+}
+
+BoundingSphere::BoundingSphere(const glm::vec3& center, float radius)
+	: Center(center), Radius(radius)
+{
+}
+
+BoundingSphere BoundingSphere::FromAABB(const AABB& box)
+{
+	return BoundingSphere(box.GetCenter(), glm::length(box.GetExtents()));
+}
+
+bool BoundingSphere::Overlaps(const AABB& box) const
+{
+	//Closest point in the box to the center
+	glm::vec3 closest = glm::clamp(Center, box.Min, box.Max);
+	glm::vec3 offset = closest - Center;
+	return glm::dot(offset, offset) <= Radius * Radius;
+}
+
+Frustum::Frustum()
+{
+	for (int i = 0; i < 8; i++)
+	{
+		_normalX[i] = _normalY[i] = _normalZ[i] = 0.0f;
+		_distance[i] = FLT_MAX;
+	}
+}
+
+Frustum::Frustum(const glm::mat4& viewProjection)
+	: Frustum()
+{
+	//Rows of the matrix (glm is column major)
+	glm::vec4 rows[4];
+	for (int i = 0; i < 4; i++)
+		rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+
+	//Left, right, bottom, top, near, far
+	glm::vec4 planes[6] =
+	{
+		rows[3] + rows[0], rows[3] - rows[0],
+		rows[3] + rows[1], rows[3] - rows[1],
+		rows[3] + rows[2], rows[3] - rows[2]
+	};
+
+	for (int i = 0; i < 6; i++)
+	{
+		float length = glm::length(glm::vec3(planes[i]));
+		_normalX[i] = planes[i].x / length;
+		_normalY[i] = planes[i].y / length;
+		_normalZ[i] = planes[i].z / length;
+		_distance[i] = planes[i].w / length;
+	}
+}
+
+bool Frustum::Intersects(const AABB& box) const
+{
+	if (!box.IsValid())
+		return false;
+
+	return TestPlanes(box.GetCenter(), box.GetExtents(), 0.0f);
+}
+
+bool Frustum::Intersects(const BoundingSphere& sphere) const
+{
+	return TestPlanes(sphere.Center, glm::vec3(0.0f), sphere.Radius);
+}
+
+bool Frustum::TestPlanes(const glm::vec3& center, const glm::vec3& extents, float radius) const
+{
+#ifdef BOUNDS_USE_SSE2
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 cx = _mm_set1_ps(center.x);
+	const __m128 cy = _mm_set1_ps(center.y);
+	const __m128 cz = _mm_set1_ps(center.z);
+	const __m128 ex = _mm_set1_ps(extents.x);
+	const __m128 ey = _mm_set1_ps(extents.y);
+	const __m128 ez = _mm_set1_ps(extents.z);
+	const __m128 r = _mm_set1_ps(radius);
+
+	int outside = 0;
+	for (int i = 0; i < 8; i += 4)
+	{
+		__m128 nx = _mm_load_ps(_normalX + i);
+		__m128 ny = _mm_load_ps(_normalY + i);
+		__m128 nz = _mm_load_ps(_normalZ + i);
+
+		//Signed distance of the center from each plane
+		__m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, cx), _mm_mul_ps(ny, cy)), _mm_add_ps(_mm_mul_ps(nz, cz), _mm_load_ps(_distance + i)));
+		//How far the box reaches towards each plane
+		__m128 reach = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_andnot_ps(signMask, nx), ex), _mm_mul_ps(_mm_andnot_ps(signMask, ny), ey)),
+			_mm_add_ps(_mm_mul_ps(_mm_andnot_ps(signMask, nz), ez), r));
+
+		outside |= _mm_movemask_ps(_mm_cmplt_ps(_mm_add_ps(dist, reach), zero));
+	}
+	return outside == 0;
+#else
+	for (int i = 0; i < 6; i++)
+	{
+		float dist = _normalX[i] * center.x + _normalY[i] * center.y + _normalZ[i] * center.z + _distance[i];
+		float reach = std::abs(_normalX[i]) * extents.x + std::abs(_normalY[i]) * extents.y + std::abs(_normalZ[i]) * extents.z + radius;
+		if (dist + reach < 0.0f)
+			return false;
+	}
+	return true;
+#endif
+}
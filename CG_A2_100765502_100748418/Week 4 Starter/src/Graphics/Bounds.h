@@ -0,0 +1,75 @@
+#pragma once
+#include <cfloat>
+#include <GLM/glm.hpp>
+
+//Axis aligned bounding box
+struct AABB
+{
+	glm::vec3 Min = glm::vec3(FLT_MAX);
+	glm::vec3 Max = glm::vec3(-FLT_MAX);
+
+	AABB();
+	AABB(const glm::vec3& min, const glm::vec3& max);
+
+	//Grows the box to hold the point / box
+	void Expand(const glm::vec3& point);
+	void Expand(const AABB& other);
+
+	//The box around this box after it's been transformed
+	AABB Transformed(const glm::mat4& transform) const;
+
+	//Does this box touch / fully hold the other box
+	bool Overlaps(const AABB& other) const;
+	bool Contains(const AABB& other) const;
+	//Distance along the ray to where it enters the box, returns false if it misses or enters past maxDistance
+	//*inverseDirection is 1 / direction, so it can be worked out once per ray
+	bool IntersectsRay(const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance, float& distance) const;
+
+	//Getters
+	glm::vec3 GetCenter() const;
+	//Half the size on each axis
+	glm::vec3 GetExtents() const;
+	//False until something has been added to the box
+	bool IsValid() const;
+	float GetSurfaceArea() const;
+};
+
+//Sphere around a mesh, cheaper to test than a box but looser
+struct BoundingSphere
+{
+	glm::vec3 Center = glm::vec3(0.0f);
+	float Radius = 0.0f;
+
+	BoundingSphere();
+	BoundingSphere(const glm::vec3& center, float radius);
+	//Smallest sphere holding the box
+	static BoundingSphere FromAABB(const AABB& box);
+
+	//Does the sphere touch the box
+	bool Overlaps(const AABB& box) const;
+};
+
+//The six planes of a camera's view volume
+//*Planes are stored per component so four of them can be tested at once
+class Frustum
+{
+public:
+	Frustum();
+	//Pulls the planes out of a view projection matrix, they end up in whatever space the matrix takes in
+	explicit Frustum(const glm::mat4& viewProjection);
+
+	//Returns false if the box / sphere is fully outside any plane
+	//*Conservative, something near a corner of the frustum can pass without being on screen
+	bool Intersects(const AABB& box) const;
+	bool Intersects(const BoundingSphere& sphere) const;
+
+private:
+	//Tests a center against every plane, with a radius per plane (extents projected onto the normal)
+	bool TestPlanes(const glm::vec3& center, const glm::vec3& extents, float radius) const;
+
+	//Two groups of four, the last two planes are padding that everything is inside
+	alignas(16) float _normalX[8];
+	alignas(16) float _normalY[8];
+	alignas(16) float _normalZ[8];
+	alignas(16) float _distance[8];
+};
@@ -0,0 +1,27 @@
+#pragma once
+#include "Graphics/Bounds.h"
+
+//Lets an entity be skipped when it's off screen
+//*Entities without one are always drawn (the skybox for example)
+struct CullingComponent
+{
+	//Bounds of the mesh in its own space, set once when it's loaded
+	AABB LocalBounds;
+	//LocalBounds moved by the entity's world transform, updated along with the world matrix
+	AABB WorldBounds;
+	//Was it inside the camera frustum this frame
+	bool Visible = true;
+	//Leaf in the SpatialIndex tree, -1 until it's been added
+	int Proxy = -1;
+
+	CullingComponent() = default;
+	CullingComponent(const AABB& localBounds)
+		: LocalBounds(localBounds), WorldBounds(localBounds)
+	{
+	}
+
+	void UpdateWorldBounds(const glm::mat4& worldTransform)
+	{
+		WorldBounds = LocalBounds.Transformed(worldTransform);
+	}
+};
@@ -0,0 +1,200 @@
+#include "DeferredRenderer.h"
+
+#include <cmath>
+#include <utility>
+#include <GLM/gtc/matrix_inverse.hpp>
+
+#include "Graphics/ShaderLibrary.h"
+
+DeferredRenderer::DeferredRenderer()
+{
+}
+
+DeferredRenderer::~DeferredRenderer()
+{
+	Unload();
+}
+
+DeferredRenderer::DeferredRenderer(DeferredRenderer&& other) noexcept
+{
+	*this = std::move(other);
+}
+
+DeferredRenderer& DeferredRenderer::operator=(DeferredRenderer&& other) noexcept
+{
+	std::swap(_gBuffer, other._gBuffer);
+	std::swap(_geometryShader, other._geometryShader);
+	std::swap(_ambientShader, other._ambientShader);
+	std::swap(_pointLightShader, other._pointLightShader);
+	std::swap(_lightsDrawn, other._lightsDrawn);
+	return *this;
+}
+
+void DeferredRenderer::Init(unsigned width, unsigned height)
+{
+	//Albedo + specular, normal + shininess, depth
+	_gBuffer = new Framebuffer();
+	_gBuffer->AddColorTarget(GL_RGBA8);
+	_gBuffer->AddColorTarget(GL_RGBA16F);
+	_gBuffer->AddDepthTarget();
+	_gBuffer->Init(width, height);
+
+	_geometryShader = ShaderLibrary::Load("shaders/vertex_shader.glsl", "shaders/frag_gbuffer.glsl");
+	_ambientShader = ShaderLibrary::Load("shaders/passthrough_vert.glsl", "shaders/Post/deferred_ambient_frag.glsl");
+	_pointLightShader = ShaderLibrary::Load("shaders/passthrough_vert.glsl", "shaders/Post/deferred_point_light_frag.glsl");
+}
+
+void DeferredRenderer::Unload()
+{
+	if (_gBuffer != nullptr)
+	{
+		_gBuffer->Unload();
+		delete _gBuffer;
+		_gBuffer = nullptr;
+	}
+}
+
+void DeferredRenderer::Reshape(unsigned width, unsigned height)
+{
+	_gBuffer->Reshape(width, height);
+}
+
+void DeferredRenderer::ApplyPendingResize()
+{
+	_gBuffer->ApplyPendingResize();
+}
+
+void DeferredRenderer::BeginGeometryPass()
+{
+	_gBuffer->Clear();
+	_gBuffer->Bind();
+	_gBuffer->SetViewport();
+}
+
+void DeferredRenderer::EndGeometryPass()
+{
+	_gBuffer->Unbind();
+}
+
+void DeferredRenderer::LightingPass(const std::vector<PointLight>& lights, const glm::mat4& view, const glm::mat4& projection, Framebuffer* output)
+{
+	glm::mat4 viewProjection = projection * view;
+	glm::vec3 camPos = glm::inverse(view) * glm::vec4(0, 0, 0, 1);
+
+	output->Bind();
+	output->SetViewport();
+
+	//Lighting passes are fullscreen, depth gets copied across at the end instead
+	GLStateCache::SetEnabled(GL_DEPTH_TEST, false);
+	GLStateCache::DepthMask(false);
+
+	_gBuffer->BindColorAsTexture(0, ALBEDO_SPEC_SLOT);
+	_gBuffer->BindColorAsTexture(1, NORMAL_SHININESS_SLOT);
+	_gBuffer->BindDepthAsTexture(DEPTH_SLOT);
+
+	//Ambient and the scene light cover everything that was drawn
+	GLStateCache::UseProgram(_ambientShader);
+	_ambientShader->SetUniform("u_UVScale", _gBuffer->GetUVScale());
+	Framebuffer::DrawFullscreenQuad();
+
+	//Point lights add on top, each only over the pixels it can reach
+	_lightsDrawn = 0;
+	if (!lights.empty())
+	{
+		GLStateCache::SetEnabled(GL_BLEND, true);
+		GLStateCache::BlendFunc(GL_ONE, GL_ONE);
+		GLStateCache::SetEnabled(GL_SCISSOR_TEST, true);
+
+		GLStateCache::UseProgram(_pointLightShader);
+		_pointLightShader->SetUniform("u_UVScale", _gBuffer->GetUVScale());
+
+		for (unsigned i = 0; i < lights.size(); i++)
+		{
+			glm::ivec4 rect;
+			if (!GetScissorRect(lights[i], viewProjection, camPos, rect))
+				continue;
+
+			glScissor(rect.x, rect.y, rect.z, rect.w);
+			_pointLightShader->SetUniform("u_PointLightPos", lights[i].Position);
+			_pointLightShader->SetUniform("u_PointLightCol", lights[i].Color * lights[i].Intensity);
+			_pointLightShader->SetUniform("u_PointLightRadius", lights[i].Radius);
+			Framebuffer::DrawFullscreenQuad();
+			_lightsDrawn++;
+		}
+
+		GLStateCache::SetEnabled(GL_SCISSOR_TEST, false);
+		GLStateCache::SetEnabled(GL_BLEND, false);
+	}
+
+	GLStateCache::UseProgram(GL_NONE);
+	_gBuffer->UnbindTexture(ALBEDO_SPEC_SLOT);
+	_gBuffer->UnbindTexture(NORMAL_SHININESS_SLOT);
+	_gBuffer->UnbindTexture(DEPTH_SLOT);
+
+	GLStateCache::DepthMask(true);
+	GLStateCache::SetEnabled(GL_DEPTH_TEST, true);
+	output->Unbind();
+
+	//Forward passes (transparent water, skybox) still need to depth test against the scene
+	_gBuffer->CopyDepthTo(*output);
+}
+
+const Shader::sptr& DeferredRenderer::GetGeometryShader() const
+{
+	return _geometryShader;
+}
+
+int DeferredRenderer::GetLightsDrawn() const
+{
+	return _lightsDrawn;
+}
+
+bool DeferredRenderer::IsReady() const
+{
+	return ShaderLibrary::IsReady(_geometryShader) && ShaderLibrary::IsReady(_ambientShader) && ShaderLibrary::IsReady(_pointLightShader);
+}
+
+bool DeferredRenderer::GetScissorRect(const PointLight& light, const glm::mat4& viewProjection, const glm::vec3& camPos, glm::ivec4& rect) const
+{
+	int width = int(_gBuffer->GetRenderWidth());
+	int height = int(_gBuffer->GetRenderHeight());
+
+	//Camera inside the light, it can reach the whole screen
+	if (glm::length(camPos - light.Position) <= light.Radius)
+	{
+		rect = glm::ivec4(0, 0, width, height);
+		return true;
+	}
+
+	//Project the corners of the box around the light's sphere
+	glm::vec2 ndcMin = glm::vec2(1.0f);
+	glm::vec2 ndcMax = glm::vec2(-1.0f);
+	for (int i = 0; i < 8; i++)
+	{
+		glm::vec3 corner = light.Position + light.Radius * glm::vec3(i & 1 ? 1.0f : -1.0f, i & 2 ? 1.0f : -1.0f, i & 4 ? 1.0f : -1.0f);
+		glm::vec4 clip = viewProjection * glm::vec4(corner, 1.0f);
+
+		//A corner behind the camera, just use the whole screen
+		if (clip.w <= 0.0f)
+		{
+			rect = glm::ivec4(0, 0, width, height);
+			return true;
+		}
+
+		glm::vec2 ndc = glm::vec2(clip) / clip.w;
+		ndcMin = glm::min(ndcMin, ndc);
+		ndcMax = glm::max(ndcMax, ndc);
+	}
+
+	ndcMin = glm::clamp(ndcMin, glm::vec2(-1.0f), glm::vec2(1.0f));
+	ndcMax = glm::clamp(ndcMax, glm::vec2(-1.0f), glm::vec2(1.0f));
+
+	//NDC to pixels
+	int x0 = int((ndcMin.x * 0.5f + 0.5f) * width);
+	int y0 = int((ndcMin.y * 0.5f + 0.5f) * height);
+	int x1 = int(std::ceil((ndcMax.x * 0.5f + 0.5f) * width));
+	int y1 = int(std::ceil((ndcMax.y * 0.5f + 0.5f) * height));
+
+	rect = glm::ivec4(x0, y0, x1 - x0, y1 - y0);
+	return rect.z > 0 && rect.w > 0;
+}
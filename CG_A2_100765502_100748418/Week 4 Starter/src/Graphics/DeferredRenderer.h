@@ -0,0 +1,67 @@
+#pragma once
+#include <vector>
+
+#include "Graphics/Framebuffer.h"
+#include "Graphics/PointLight.h"
+
+//Deferred shading
+//*Opaque geometry is drawn once into a G-buffer (albedo + specular, normal + shininess, depth)
+//*then lit in screen space, so each light only costs the pixels it covers instead of every drawn fragment
+class DeferredRenderer
+{
+public:
+	//Slots the G-buffer gets bound to for the lighting passes
+	static const int ALBEDO_SPEC_SLOT = 0;
+	static const int NORMAL_SHININESS_SLOT = 1;
+	static const int DEPTH_SLOT = 2;
+
+	DeferredRenderer();
+	//Deconstructor
+	//*Unloads the G-buffer
+	~DeferredRenderer();
+
+	//The G-buffer can only have one owner, but the scene needs to be able to move components around
+	DeferredRenderer(const DeferredRenderer& other) = delete;
+	DeferredRenderer& operator=(const DeferredRenderer& other) = delete;
+	DeferredRenderer(DeferredRenderer&& other) noexcept;
+	DeferredRenderer& operator=(DeferredRenderer&& other) noexcept;
+
+	//Creates the G-buffer and loads the shaders
+	void Init(unsigned width, unsigned height);
+	//Deletes the G-buffer
+	void Unload();
+
+	//Reshapes the G-buffer (see Framebuffer::Reshape)
+	void Reshape(unsigned width, unsigned height);
+	void ApplyPendingResize();
+
+	//Binds and clears the G-buffer, draw opaque geometry using the geometry shader after this
+	void BeginGeometryPass();
+	//Unbinds the G-buffer
+	void EndGeometryPass();
+
+	//Lights the G-buffer into output, then copies depth into it so forward passes can depth test afterwards
+	//*The scene light and ambient go in one fullscreen pass, each point light is added inside its screen rectangle
+	//*Camera and scene light come from the shared uniform blocks (see ShaderBlocks.h)
+	void LightingPass(const std::vector<PointLight>& lights, const glm::mat4& view, const glm::mat4& projection, Framebuffer* output);
+
+	//Getters
+	//Writes the G-buffer, takes the same material uniforms as frag_phong
+	const Shader::sptr& GetGeometryShader() const;
+	//How many point lights were on screen last frame
+	int GetLightsDrawn() const;
+	//False while any of the geometry or lighting programs is still being built (see ShaderLibrary::IsReady)
+	bool IsReady() const;
+
+private:
+	//Works out the pixels a light can reach, returns false if it's off screen
+	bool GetScissorRect(const PointLight& light, const glm::mat4& viewProjection, const glm::vec3& camPos, glm::ivec4& rect) const;
+
+	Framebuffer* _gBuffer = nullptr;
+
+	Shader::sptr _geometryShader;
+	Shader::sptr _ambientShader;
+	Shader::sptr _pointLightShader;
+
+	int _lightsDrawn = 0;
+};
@@ -0,0 +1,140 @@
+#include "DrawDataBuffer.h"
+
+#include <Logging.h>
+
+DrawDataBuffer::DrawDataBuffer()
+{
+}
+
+DrawDataBuffer::~DrawDataBuffer()
+{
+	Unload();
+}
+
+void DrawDataBuffer::Init(size_t maxDraws, GLuint binding)
+{
+	Unload();
+
+	_maxDraws = maxDraws;
+	_binding = binding;
+
+	GLint alignment = 1;
+	glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	_regionSize = maxDraws * sizeof(DrawData);
+	_regionSize = (_regionSize + alignment - 1) / alignment * alignment;
+
+	//Coherent, so writes are visible to the GPU without flushing them
+	GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	glCreateBuffers(1, &_handle);
+	glNamedBufferStorage(_handle, _regionSize * REGION_COUNT, nullptr, flags);
+	_mapped = static_cast<char*>(glMapNamedBufferRange(_handle, 0, _regionSize * REGION_COUNT, flags));
+	if (_mapped == nullptr)
+		LOG_ERROR("Failed to map the draw data buffer");
+
+	_region = REGION_COUNT - 1;
+	_nextDraw = 0;
+}
+
+void DrawDataBuffer::Unload()
+{
+	for (GLsync& fence : _fences)
+	{
+		if (fence != nullptr)
+		{
+			glDeleteSync(fence);
+			fence = nullptr;
+		}
+	}
+
+	if (_handle != GL_NONE)
+	{
+		glUnmapNamedBuffer(_handle);
+		glDeleteBuffers(1, &_handle);
+		_handle = GL_NONE;
+		_mapped = nullptr;
+		_maxDraws = 0;
+		_regionSize = 0;
+	}
+}
+
+void DrawDataBuffer::BeginFrame()
+{
+	_drawCount = 0;
+	StartRegion((_region + 1) % REGION_COUNT);
+}
+
+void DrawDataBuffer::EndFrame()
+{
+	if (_fences[_region] != nullptr)
+		glDeleteSync(_fences[_region]);
+	_fences[_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+GLuint DrawDataBuffer::Push(const glm::mat4& modelViewProjection, const glm::mat4& model, const glm::mat3& normalMatrix)
+{
+	if (_nextDraw >= _maxDraws)
+	{
+		//Out of room, hand this region to the GPU and carry on in the next one
+		EndFrame();
+		StartRegion((_region + 1) % REGION_COUNT);
+	}
+
+	//Written straight into the mapping, one after another
+	DrawData* data = reinterpret_cast<DrawData*>(_mapped + _region * _regionSize) + _nextDraw;
+	data->ModelViewProjection = modelViewProjection;
+	data->Model = model;
+	data->NormalMatrix = glm::mat4(normalMatrix);
+
+	_drawCount++;
+	return GLuint(_nextDraw++);
+}
+
+GLuint DrawDataBuffer::GetHandle() const
+{
+	return _handle;
+}
+
+size_t DrawDataBuffer::GetMaxDraws() const
+{
+	return _maxDraws;
+}
+
+size_t DrawDataBuffer::GetDrawCount() const
+{
+	return _drawCount;
+}
+
+size_t DrawDataBuffer::GetRemaining() const
+{
+	return _maxDraws - _nextDraw;
+}
+
+size_t DrawDataBuffer::GetStallCount() const
+{
+	return _stallCount;
+}
+
+void DrawDataBuffer::StartRegion(int region)
+{
+	_region = region;
+	_nextDraw = 0;
+
+	GLsync& fence = _fences[_region];
+	if (fence != nullptr)
+	{
+		//Check without waiting first, so only real stalls get counted
+		GLenum result = glClientWaitSync(fence, 0, 0);
+		if (result == GL_TIMEOUT_EXPIRED)
+		{
+			_stallCount++;
+			do
+			{
+				result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+			} while (result == GL_TIMEOUT_EXPIRED);
+		}
+		glDeleteSync(fence);
+		fence = nullptr;
+	}
+
+	glBindBufferRange(GL_SHADER_STORAGE_BUFFER, _binding, _handle, _region * _regionSize, _maxDraws * sizeof(DrawData));
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <cstddef>
+#include <glad/glad.h>
+
+#include "Graphics/ShaderBlocks.h"
+
+//Per draw matrices in a persistently mapped shader storage buffer
+//*The buffer is split into REGION_COUNT regions, the CPU writes one while the GPU may still be reading the others
+//*Each region is fenced once it's been used, and waited on before it's written again
+//*Push writes the next DrawData and returns its draw id, shaders index DrawDataBlock with it
+class DrawDataBuffer
+{
+public:
+	//Frames the CPU can run ahead of the GPU before it has to wait
+	static const int REGION_COUNT = 3;
+
+	DrawDataBuffer();
+	//Deconstructor
+	//*Unmaps and deletes the buffer
+	~DrawDataBuffer();
+
+	//A buffer owns its handle and mapping
+	DrawDataBuffer(const DrawDataBuffer& other) = delete;
+	DrawDataBuffer& operator=(const DrawDataBuffer& other) = delete;
+
+	//Creates a buffer of REGION_COUNT regions that each fit maxDraws draws
+	void Init(size_t maxDraws, GLuint binding);
+	//Unmaps and deletes the buffer
+	void Unload();
+
+	//Moves to the next region and binds it, call before the first Push of a frame
+	void BeginFrame();
+	//Fences the region so it isn't written again until the GPU is done with it
+	void EndFrame();
+
+	//Writes one draw's matrices and returns the id to draw it with
+	//*If the region fills up mid frame it's fenced and the next one is started, so ids go back to 0
+	//*Anyone holding ids for later draws (IndirectRenderer) has to draw them before a push that would do that, see GetRemaining
+	GLuint Push(const glm::mat4& modelViewProjection, const glm::mat4& model, const glm::mat3& normalMatrix);
+
+	//Getters
+	GLuint GetHandle() const;
+	size_t GetMaxDraws() const;
+	//Draws pushed since BeginFrame
+	size_t GetDrawCount() const;
+	//Pushes left before the next region is started
+	size_t GetRemaining() const;
+	//How many times BeginFrame had to wait on the GPU
+	size_t GetStallCount() const;
+
+private:
+	//Waits on the region's fence, then binds it
+	void StartRegion(int region);
+
+	GLuint _handle = GL_NONE;
+	GLuint _binding = 0;
+	//Start of the persistent mapping
+	char* _mapped = nullptr;
+
+	size_t _maxDraws = 0;
+	//Bytes between regions, rounded up to the storage buffer offset alignment
+	size_t _regionSize = 0;
+
+	int _region = 0;
+	//Next free slot in the current region
+	size_t _nextDraw = 0;
+	size_t _drawCount = 0;
+	size_t _stallCount = 0;
+	GLsync _fences[REGION_COUNT] = {};
+};
@@ -15,6 +15,7 @@ DepthTarget::~DepthTarget()
 void DepthTarget::Unload()
 {
 	//Deletes the texture at the specific handle
+	GLStateCache::ForgetTexture(_texture.GetHandle());
 	glDeleteTextures(1, &_texture.GetHandle());
 }
 
@@ -26,6 +27,8 @@ ColorTarget::~ColorTarget()
 
 void ColorTarget::Unload()
 {
+	for (unsigned i = 0; i < _numAttachments; i++)
+		GLStateCache::ForgetTexture(_textures[i].GetHandle());
 	glDeleteTextures(_numAttachments, &_textures[0].GetHandle());
 }
 
@@ -41,6 +44,7 @@ Framebuffer::~Framebuffer()
 void Framebuffer::Unload()
 {
 	//Deletes the framebuffer
+	GLStateCache::ForgetFramebuffer(_FBO);
 	glDeleteFramebuffers(1, &_FBO);
 	//Sets init to false
 	_isInit = false;
@@ -57,22 +61,25 @@ void Framebuffer::Init(unsigned width, unsigned height)
 
 void Framebuffer::Init()
 {
+	//Allocate for the whole bucket so small resizes don't need new textures
+	_allocWidth = GetBucketSize(_width);
+	_allocHeight = GetBucketSize(_height);
+	_resizePending = false;
+
 	//Generates the FBO
 	glGenFramebuffers(1, &_FBO);
 	//Bind it
-	glBindFramebuffer(GL_FRAMEBUFFER, _FBO);
+	GLStateCache::BindFramebuffer(GL_FRAMEBUFFER, _FBO);
 
 	if (_depthActive)
 	{
 		//because we have depth we need to clear our depth bit
 		_clearFlag |= GL_DEPTH_BUFFER_BIT;
 
-		//Generate the texture
-		glGenTextures(1, &_depth._texture.GetHandle());
-		//Binds the texture
-		glBindTexture(GL_TEXTURE_2D, _depth._texture.GetHandle());
+		//Generate the texture (created rather than bound, so no texture unit gets changed behind GLStateCache)
+		glCreateTextures(GL_TEXTURE_2D, 1, &_depth._texture.GetHandle());
 		//Sets the texture data
-		glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH_COMPONENT24, _width, _height);
+		glTextureStorage2D(_depth._texture.GetHandle(), 1, GL_DEPTH_COMPONENT24, _allocWidth, _allocHeight);
 
 		//Set texture parameters
 		glTextureParameteri(_depth._texture.GetHandle(), GL_TEXTURE_MIN_FILTER, _filter);
@@ -82,8 +89,6 @@ void Framebuffer::Init()
 
 		//Sets up as a framebuffer texture
 		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, _depth._texture.GetHandle(), 0);
-
-		glBindTexture(GL_TEXTURE_2D, GL_NONE);
 	}
 
 	//If there is more than zero color attachments
@@ -95,17 +100,15 @@ void Framebuffer::Init()
 		//Creates the GLuints to hold the new texture handles;
 		GLuint* textureHandles = new GLuint[_color._numAttachments];
 
-		glGenTextures(_color._numAttachments, textureHandles);
+		glCreateTextures(GL_TEXTURE_2D, _color._numAttachments, textureHandles);
 
 		//Loops through them
 		for (unsigned i = 0; i < _color._numAttachments; i++)
 		{
 			_color._textures[i].GetHandle() = textureHandles[i];
 
-			//Binds the texture
-			glBindTexture(GL_TEXTURE_2D, _color._textures[i].GetHandle());
 			//Sets the texture storage
-			glTexStorage2D(GL_TEXTURE_2D, 1, _color._formats[i], _width, _height);
+			glTextureStorage2D(_color._textures[i].GetHandle(), 1, _color._formats[i], _allocWidth, _allocHeight);
 
 			//Set texture parameters
 			glTextureParameteri(_color._textures[i].GetHandle(), GL_TEXTURE_MIN_FILTER, _filter);
@@ -118,12 +121,15 @@ void Framebuffer::Init()
 		}
 
 		delete[] textureHandles;
+
+		//Draw buffers stay with the FBO, so they only need setting here rather than every bind
+		GLStateCache::DrawBuffers(_FBO, _color._numAttachments, &_color._buffers[0]);
 	}
 
 	//Make sure it's set up right
 	CheckFBO();
 	//Unbind buffer
-	glBindFramebuffer(GL_FRAMEBUFFER, GL_NONE);
+	GLStateCache::BindFramebuffer(GL_FRAMEBUFFER, GL_NONE);
 	//Set init to true
 	_isInit = true;
 }
@@ -153,25 +159,35 @@ void Framebuffer::AddColorTarget(GLenum format)
 
 void Framebuffer::BindDepthAsTexture(int textureSlot) const
 {
-	_depth._texture.Bind(textureSlot);
+	GLStateCache::BindTexture(textureSlot, _depth._texture.GetHandle());
 }
 
 void Framebuffer::BindColorAsTexture(unsigned colorBuffer, int textureSlot) const
 {
-	_color._textures[colorBuffer].Bind(textureSlot);
+	GLStateCache::BindTexture(textureSlot, _color._textures[colorBuffer].GetHandle());
 }
 
 void Framebuffer::UnbindTexture(int textureSlot) const
 {
 	//Binds textures to GL_NONE
-	glActiveTexture(GL_TEXTURE0 + textureSlot);
-	glBindTexture(GL_TEXTURE_2D, GL_NONE);
+	GLStateCache::BindTexture(textureSlot, GL_NONE);
 }
 
 void Framebuffer::Reshape(unsigned width, unsigned height)
 {
 	//Set size
 	SetSize(width, height);
+
+	//Still the same bucket? Then we just render to a different part of the textures
+	//*Otherwise wait until the resize settles, windows get resized many times during a drag
+	_resizePending = GetBucketSize(width) != _allocWidth || GetBucketSize(height) != _allocHeight;
+}
+
+bool Framebuffer::ApplyPendingResize()
+{
+	if (!_resizePending)
+		return false;
+
 	//Unloads the framebuffer
 	Unload();
 	//Unload the depth target
@@ -180,6 +196,8 @@ void Framebuffer::Reshape(unsigned width, unsigned height)
 	_color.Unload();
 	//Inits the framebuffer
 	Init();
+
+	return true;
 }
 
 void Framebuffer::SetSize(unsigned width, unsigned height)
@@ -191,22 +209,55 @@ void Framebuffer::SetSize(unsigned width, unsigned height)
 
 void Framebuffer::SetViewport() const
 {
-	glViewport(0, 0, _width, _height);
+	GLStateCache::Viewport(0, 0, GetRenderWidth(), GetRenderHeight());
 }
 
-void Framebuffer::Bind() const
+unsigned Framebuffer::GetRenderWidth() const
 {
-	glBindFramebuffer(GL_FRAMEBUFFER, _FBO);
+	//Can't render past the end of the textures if they haven't grown yet
+	return _width < _allocWidth ? _width : _allocWidth;
+}
 
-	if (_color._numAttachments)
-	{
-		glDrawBuffers(_color._numAttachments, &_color._buffers[0]);
-	}
+unsigned Framebuffer::GetRenderHeight() const
+{
+	return _height < _allocHeight ? _height : _allocHeight;
+}
+
+unsigned Framebuffer::GetAllocatedWidth() const
+{
+	return _allocWidth;
+}
+
+unsigned Framebuffer::GetAllocatedHeight() const
+{
+	return _allocHeight;
+}
+
+glm::vec2 Framebuffer::GetUVScale() const
+{
+	return glm::vec2(float(GetRenderWidth()) / float(_allocWidth), float(GetRenderHeight()) / float(_allocHeight));
+}
+
+bool Framebuffer::IsResizePending() const
+{
+	return _resizePending;
+}
+
+unsigned Framebuffer::GetBucketSize(unsigned size)
+{
+	//Never zero, a minimized window still needs valid textures
+	unsigned buckets = (size + BUCKET_SIZE - 1) / BUCKET_SIZE;
+	return (buckets == 0 ? 1 : buckets) * BUCKET_SIZE;
+}
+
+void Framebuffer::Bind() const
+{
+	GLStateCache::BindFramebuffer(GL_FRAMEBUFFER, _FBO);
 }
 
 void Framebuffer::Unbind() const
 {
-	glBindFramebuffer(GL_FRAMEBUFFER, GL_NONE);
+	GLStateCache::BindFramebuffer(GL_FRAMEBUFFER, GL_NONE);
 }
 
 void Framebuffer::RenderToFSQ() const
@@ -223,19 +274,46 @@ void Framebuffer::RenderToFSQ() const
 
 void Framebuffer::DrawToBackbuffer()
 {
-	glBindFramebuffer(GL_READ_FRAMEBUFFER, _FBO);
-	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, GL_NONE);
+	GLStateCache::BindFramebuffer(GL_READ_FRAMEBUFFER, _FBO);
+	GLStateCache::BindFramebuffer(GL_DRAW_FRAMEBUFFER, GL_NONE);
+
+	//Blits the rendered part of the framebuffer to the back buffer (stretched if a resize is pending)
+	GLenum filter = GetRenderWidth() == _width && GetRenderHeight() == _height ? GL_NEAREST : GL_LINEAR;
+	glBlitFramebuffer(0, 0, GetRenderWidth(), GetRenderHeight(), 0, 0, _width, _height, GL_COLOR_BUFFER_BIT, filter);
+	GLStateCache::BindFramebuffer(GL_READ_FRAMEBUFFER, GL_NONE);
+}
+
+void Framebuffer::DrawToFramebuffer(const Framebuffer& target) const
+{
+	GLStateCache::BindFramebuffer(GL_READ_FRAMEBUFFER, _FBO);
+	GLStateCache::BindFramebuffer(GL_DRAW_FRAMEBUFFER, target._FBO);
+
+	//Blits the colour across, stretching if the sizes differ
+	glBlitFramebuffer(0, 0, GetRenderWidth(), GetRenderHeight(), 0, 0, target.GetRenderWidth(), target.GetRenderHeight(), GL_COLOR_BUFFER_BIT, GL_LINEAR);
+	GLStateCache::BindFramebuffer(GL_READ_FRAMEBUFFER, GL_NONE);
+	GLStateCache::BindFramebuffer(GL_DRAW_FRAMEBUFFER, GL_NONE);
+}
+
+void Framebuffer::CopyDepthTo(const Framebuffer& target) const
+{
+	GLStateCache::BindFramebuffer(GL_READ_FRAMEBUFFER, _FBO);
+	GLStateCache::BindFramebuffer(GL_DRAW_FRAMEBUFFER, target._FBO);
 
-	//Blits the framebuffer to the back buffer
-	glBlitFramebuffer(0, 0, _width, _height, 0, 0, _width, _height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
-	glBindFramebuffer(GL_READ_FRAMEBUFFER, GL_NONE);
+	//Depth can't be filtered so the sizes need to match
+	glBlitFramebuffer(0, 0, GetRenderWidth(), GetRenderHeight(), 0, 0, target.GetRenderWidth(), target.GetRenderHeight(), GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+	GLStateCache::BindFramebuffer(GL_READ_FRAMEBUFFER, GL_NONE);
+	GLStateCache::BindFramebuffer(GL_DRAW_FRAMEBUFFER, GL_NONE);
 }
 
 void Framebuffer::Clear()
 {
-	glBindFramebuffer(GL_FRAMEBUFFER, _FBO);
+	GLStateCache::BindFramebuffer(GL_FRAMEBUFFER, _FBO);
+	//Only clear the part we render to
+	GLStateCache::SetEnabled(GL_SCISSOR_TEST, true);
+	glScissor(0, 0, GetRenderWidth(), GetRenderHeight());
 	glClear(_clearFlag);
-	glBindFramebuffer(GL_FRAMEBUFFER, GL_NONE);
+	GLStateCache::SetEnabled(GL_SCISSOR_TEST, false);
+	GLStateCache::BindFramebuffer(GL_FRAMEBUFFER, GL_NONE);
 }
 
 bool Framebuffer::CheckFBO()
@@ -282,7 +360,7 @@ void Framebuffer::InitFullscreenQuad()
 	//Generates vertex array
 	glGenVertexArrays(1, &_fullscreenQuadVAO);
 	//Binds VAO
-	glBindVertexArray(_fullscreenQuadVAO);
+	GLStateCache::BindVertexArray(_fullscreenQuadVAO);
 
 	//Enables 2 vertex attrib array slots
 	glEnableVertexAttribArray(0); //Vertices
@@ -305,14 +383,14 @@ void Framebuffer::InitFullscreenQuad()
 #pragma warning(pop)
 
 	glBindBuffer(GL_ARRAY_BUFFER, GL_NONE);
-	glBindVertexArray(GL_NONE);
+	GLStateCache::BindVertexArray(GL_NONE);
 }
 
 void Framebuffer::DrawFullscreenQuad()
 {
-	glBindVertexArray(_fullscreenQuadVAO);
+	GLStateCache::BindVertexArray(_fullscreenQuadVAO);
 	glDrawArrays(GL_TRIANGLES, 0, 6);
-	glBindVertexArray(GL_NONE);
+	GLStateCache::BindVertexArray(GL_NONE);
 }
 
 
@@ -3,6 +3,8 @@
 #include <Texture2D.h>
 #include <Shader.h>
 
+#include "Graphics/GLStateCache.h"
+
 struct DepthTarget
 {
 	//Deconstructor for Depth Target
@@ -60,12 +62,35 @@ public:
 	void UnbindTexture(int textureSlot) const;
 
 	//Reshapes the framebuffer
+	//*Textures are allocated in size buckets, if the new size still fits in the bucket
+	//*nothing is reallocated and we just render to a smaller part of them
+	//*If the bucket changes the reallocation waits until ApplyPendingResize
 	void Reshape(unsigned width, unsigned height);
+	//Reallocates the textures if Reshape moved us into a different bucket
+	//*Returns true if anything was reallocated
+	bool ApplyPendingResize();
 	//Sets the size of the framebuffer
 	void SetSize(unsigned width, unsigned height);
 
 	//Sets the viewport to fullscreen (using the size of framebuffer)
 	void SetViewport() const;
+
+	//Size of the part of the textures we render to
+	//*Smaller than the framebuffer size while a resize is waiting to be applied
+	unsigned GetRenderWidth() const;
+	unsigned GetRenderHeight() const;
+	//Size the textures are actually allocated at
+	unsigned GetAllocatedWidth() const;
+	unsigned GetAllocatedHeight() const;
+	//How much of the textures the rendered part covers, for scaling UVs when sampling them
+	glm::vec2 GetUVScale() const;
+	//Is there a reallocation waiting?
+	bool IsResizePending() const;
+
+	//Rounds a size up to the bucket it gets allocated at
+	static unsigned GetBucketSize(unsigned size);
+	//Sizes are rounded up to a multiple of this
+	static const unsigned BUCKET_SIZE = 128;
 	
 	//Binds the framebuffer
 	void Bind() const;
@@ -77,6 +102,10 @@ public:
 
 	//Draws the contents of the framebuffer to the back buffer
 	void DrawToBackbuffer();
+	//Draws the colour of the framebuffer to another framebuffer
+	void DrawToFramebuffer(const Framebuffer& target) const;
+	//Copies the depth of the framebuffer into another framebuffer (both need a depth target)
+	void CopyDepthTo(const Framebuffer& target) const;
 
 	//Clears the framebuffer using our clear flag
 	void Clear();
@@ -94,6 +123,12 @@ public:
 	unsigned int _width = 0;
 	unsigned int _height = 0;
 protected:
+	//Size the textures were allocated at (a bucket at least as big as the size at the time)
+	unsigned int _allocWidth = 0;
+	unsigned int _allocHeight = 0;
+	//Reshape changed bucket and the textures haven't been reallocated yet
+	bool _resizePending = false;
+
 	//OpenGL framebuffer handle
 	GLuint _FBO;
 	//Depth attachment (either one or none)
@@ -0,0 +1,212 @@
+#include "GLStateCache.h"
+
+#include <algorithm>
+
+GLuint GLStateCache::_program = GLStateCache::UNKNOWN;
+GLuint GLStateCache::_vertexArray = GLStateCache::UNKNOWN;
+GLuint GLStateCache::_drawFramebuffer = GLStateCache::UNKNOWN;
+GLuint GLStateCache::_readFramebuffer = GLStateCache::UNKNOWN;
+//A new context has nothing bound to any unit
+GLuint GLStateCache::_textures[GLStateCache::MAX_TEXTURE_UNITS] = {};
+std::unordered_map<GLuint, std::vector<GLenum>> GLStateCache::_drawBuffers;
+std::unordered_map<GLenum, GLuint> GLStateCache::_capabilities;
+GLuint GLStateCache::_depthMask = GLStateCache::UNKNOWN;
+GLuint GLStateCache::_blendSource = GLStateCache::UNKNOWN;
+GLuint GLStateCache::_blendDestination = GLStateCache::UNKNOWN;
+GLint GLStateCache::_viewport[4] = { -1, -1, -1, -1 };
+size_t GLStateCache::_issued = 0;
+size_t GLStateCache::_skipped = 0;
+
+void GLStateCache::UseProgram(GLuint program)
+{
+	if (Changed(_program, program))
+		glUseProgram(program);
+}
+
+void GLStateCache::UseProgram(const Shader::sptr& shader)
+{
+	UseProgram(shader == nullptr ? GL_NONE : shader->GetHandle());
+}
+
+void GLStateCache::BindVertexArray(GLuint vao)
+{
+	if (Changed(_vertexArray, vao))
+		glBindVertexArray(vao);
+}
+
+void GLStateCache::BindFramebuffer(GLenum target, GLuint fbo)
+{
+	if (target == GL_FRAMEBUFFER)
+	{
+		//One call covers both, only skip it if both already match
+		if (_drawFramebuffer == fbo && _readFramebuffer == fbo)
+		{
+			_skipped++;
+			return;
+		}
+		_drawFramebuffer = _readFramebuffer = fbo;
+		_issued++;
+		glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	}
+	else if (Changed(target == GL_READ_FRAMEBUFFER ? _readFramebuffer : _drawFramebuffer, fbo))
+		glBindFramebuffer(target, fbo);
+}
+
+void GLStateCache::BindTexture(int unit, GLuint texture)
+{
+	if (unit >= MAX_TEXTURE_UNITS)
+	{
+		_issued++;
+		glBindTextureUnit(unit, texture);
+	}
+	else if (Changed(_textures[unit], texture))
+		glBindTextureUnit(unit, texture);
+}
+
+void GLStateCache::DrawBuffers(GLuint fbo, GLsizei count, const GLenum* buffers)
+{
+	std::vector<GLenum>& current = _drawBuffers[fbo];
+	if (current.size() == size_t(count) && std::equal(current.begin(), current.end(), buffers))
+	{
+		_skipped++;
+		return;
+	}
+
+	current.assign(buffers, buffers + count);
+	_issued++;
+	glNamedFramebufferDrawBuffers(fbo, count, buffers);
+}
+
+void GLStateCache::SetEnabled(GLenum capability, bool enabled)
+{
+	auto it = _capabilities.find(capability);
+	if (it != _capabilities.end() && it->second == GLuint(enabled))
+	{
+		_skipped++;
+		return;
+	}
+
+	_capabilities[capability] = GLuint(enabled);
+	_issued++;
+	if (enabled)
+		glEnable(capability);
+	else
+		glDisable(capability);
+}
+
+void GLStateCache::DepthMask(bool write)
+{
+	if (Changed(_depthMask, GLuint(write)))
+		glDepthMask(write ? GL_TRUE : GL_FALSE);
+}
+
+void GLStateCache::BlendFunc(GLenum source, GLenum destination)
+{
+	if (_blendSource == source && _blendDestination == destination)
+	{
+		_skipped++;
+		return;
+	}
+
+	_blendSource = source;
+	_blendDestination = destination;
+	_issued++;
+	glBlendFunc(source, destination);
+}
+
+void GLStateCache::Viewport(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+	if (_viewport[0] == x && _viewport[1] == y && _viewport[2] == width && _viewport[3] == height)
+	{
+		_skipped++;
+		return;
+	}
+
+	_viewport[0] = x;
+	_viewport[1] = y;
+	_viewport[2] = width;
+	_viewport[3] = height;
+	_issued++;
+	glViewport(x, y, width, height);
+}
+
+void GLStateCache::Invalidate()
+{
+	InvalidateProgram();
+	InvalidateVertexArray();
+	InvalidateTextures();
+	_drawFramebuffer = _readFramebuffer = UNKNOWN;
+	_drawBuffers.clear();
+	_capabilities.clear();
+	_depthMask = _blendSource = _blendDestination = UNKNOWN;
+	std::fill(_viewport, _viewport + 4, -1);
+}
+
+void GLStateCache::InvalidateProgram()
+{
+	_program = UNKNOWN;
+}
+
+void GLStateCache::InvalidateVertexArray()
+{
+	_vertexArray = UNKNOWN;
+}
+
+void GLStateCache::InvalidateTextures()
+{
+	std::fill(_textures, _textures + MAX_TEXTURE_UNITS, UNKNOWN);
+}
+
+void GLStateCache::ForgetTexture(GLuint texture)
+{
+	//GL unbinds a deleted texture from every unit
+	for (GLuint& bound : _textures)
+	{
+		if (bound == texture)
+			bound = GL_NONE;
+	}
+}
+
+void GLStateCache::ForgetFramebuffer(GLuint fbo)
+{
+	if (_drawFramebuffer == fbo)
+		_drawFramebuffer = GL_NONE;
+	if (_readFramebuffer == fbo)
+		_readFramebuffer = GL_NONE;
+	_drawBuffers.erase(fbo);
+}
+
+void GLStateCache::ForgetVertexArray(GLuint vao)
+{
+	if (_vertexArray == vao)
+		_vertexArray = GL_NONE;
+}
+
+size_t GLStateCache::GetIssuedCount()
+{
+	return _issued;
+}
+
+size_t GLStateCache::GetSkippedCount()
+{
+	return _skipped;
+}
+
+void GLStateCache::ResetCounters()
+{
+	_issued = 0;
+	_skipped = 0;
+}
+
+bool GLStateCache::Changed(GLuint& current, GLuint value)
+{
+	if (current == value)
+	{
+		_skipped++;
+		return false;
+	}
+
+	current = value;
+	_issued++;
+	return true;
+}
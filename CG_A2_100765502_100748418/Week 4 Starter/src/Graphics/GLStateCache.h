@@ -0,0 +1,72 @@
+#pragma once
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+#include <glad/glad.h>
+#include <Shader.h>
+
+//Shadow copy of the GL state we bind most, so binding what's already bound doesn't reach the driver
+//*Only sees calls that go through it, framework classes (Shader::Bind, ShaderMaterial::Apply, Texture2D::Bind,
+//VertexArrayObject::Render) bind things themselves, so call the matching Invalidate after using them
+//*Anything deleted has to be forgotten, GL hands the same name out again
+class GLStateCache abstract
+{
+public:
+	//Texture units that are tracked, binds to higher units always go through
+	static const int MAX_TEXTURE_UNITS = 32;
+
+	static void UseProgram(GLuint program);
+	static void UseProgram(const Shader::sptr& shader);
+	static void BindVertexArray(GLuint vao);
+	//GL_FRAMEBUFFER binds both draw and read
+	static void BindFramebuffer(GLenum target, GLuint fbo);
+	//Binds to a unit whatever the texture's target is (glBindTextureUnit)
+	static void BindTexture(int unit, GLuint texture);
+	//Draw buffers are part of the framebuffer object, so they only need setting once per fbo
+	static void DrawBuffers(GLuint fbo, GLsizei count, const GLenum* buffers);
+
+	static void SetEnabled(GLenum capability, bool enabled);
+	static void DepthMask(bool write);
+	static void BlendFunc(GLenum source, GLenum destination);
+	static void Viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+
+	//Forget everything, the next bind of anything always goes through
+	static void Invalidate();
+	static void InvalidateProgram();
+	static void InvalidateVertexArray();
+	static void InvalidateTextures();
+
+	//Call before deleting, so a new object given the same name isn't mistaken for it
+	static void ForgetTexture(GLuint texture);
+	static void ForgetFramebuffer(GLuint fbo);
+	static void ForgetVertexArray(GLuint vao);
+
+	//Getters
+	//Calls passed on to GL and calls skipped since ResetCounters
+	static size_t GetIssuedCount();
+	static size_t GetSkippedCount();
+	static void ResetCounters();
+
+private:
+	//Nothing real has this name, so the next bind always goes through
+	static const GLuint UNKNOWN = ~0u;
+
+	//Counts a call, returns true if it needs to go through
+	static bool Changed(GLuint& current, GLuint value);
+
+	static GLuint _program;
+	static GLuint _vertexArray;
+	static GLuint _drawFramebuffer;
+	static GLuint _readFramebuffer;
+	static GLuint _textures[MAX_TEXTURE_UNITS];
+	static std::unordered_map<GLuint, std::vector<GLenum>> _drawBuffers;
+	//Capability -> 0 off, 1 on, missing unknown
+	static std::unordered_map<GLenum, GLuint> _capabilities;
+	static GLuint _depthMask;
+	static GLuint _blendSource;
+	static GLuint _blendDestination;
+	static GLint _viewport[4];
+
+	static size_t _issued;
+	static size_t _skipped;
+};
@@ -0,0 +1,129 @@
+#include "IndirectRenderer.h"
+
+#include <numeric>
+
+IndirectRenderer::IndirectRenderer()
+{
+}
+
+IndirectRenderer::~IndirectRenderer()
+{
+	Unload();
+}
+
+void IndirectRenderer::Init(MeshPool& pool, DrawDataBuffer& drawData)
+{
+	Unload();
+
+	_pool = &pool;
+	_drawData = &drawData;
+
+	//Instance i of a command reads element BaseInstance + i, which is just the draw id
+	std::vector<GLuint> ids(_drawData->GetMaxDraws());
+	std::iota(ids.begin(), ids.end(), 0);
+	glCreateBuffers(1, &_drawIdBuffer);
+	glNamedBufferStorage(_drawIdBuffer, ids.size() * sizeof(GLuint), ids.data(), 0);
+
+	GLuint vao = _pool->GetVAO();
+	glVertexArrayVertexBuffer(vao, DRAW_ID_BINDING, _drawIdBuffer, 0, sizeof(GLuint));
+	glVertexArrayBindingDivisor(vao, DRAW_ID_BINDING, 1);
+	glEnableVertexArrayAttrib(vao, DRAW_ID_LOCATION);
+	glVertexArrayAttribIFormat(vao, DRAW_ID_LOCATION, 1, GL_UNSIGNED_INT, 0);
+	glVertexArrayAttribBinding(vao, DRAW_ID_LOCATION, DRAW_ID_BINDING);
+
+	glCreateBuffers(1, &_commandBuffer);
+	_commandCapacity = 0;
+}
+
+void IndirectRenderer::Unload()
+{
+	if (_commandBuffer != GL_NONE)
+	{
+		glDeleteBuffers(1, &_commandBuffer);
+		glDeleteBuffers(1, &_drawIdBuffer);
+		_commandBuffer = _drawIdBuffer = GL_NONE;
+		_commandCapacity = 0;
+	}
+}
+
+void IndirectRenderer::Begin(const ApplyMaterialFunc& applyMaterial)
+{
+	_applyMaterial = applyMaterial;
+	_commands.clear();
+	_batches.clear();
+	_batchCount = 0;
+	_commandCount = 0;
+}
+
+bool IndirectRenderer::Add(const ShaderMaterial::sptr& material, const VertexArrayObject::sptr& mesh, const glm::mat4& viewProjection, const Transform& transform)
+{
+	int id = _pool->Find(mesh);
+	if (id < 0)
+		return false;
+
+	//The next push would start a new region and the ids already queued would point into the wrong one
+	if (_drawData->GetRemaining() == 0)
+		Flush();
+
+	GLuint drawId = _drawData->Push(viewProjection * transform.WorldTransform(), transform.WorldTransform(), transform.WorldNormalMatrix());
+
+	const PoolMesh& pooled = _pool->GetMesh(id);
+	_commands.push_back({ pooled.IndexCount, 1, pooled.FirstIndex, pooled.BaseVertex, drawId });
+
+	if (_batches.empty() || _batches.back().Material != material)
+		_batches.push_back({ material, _commands.size() - 1, 0 });
+	_batches.back().CommandCount++;
+	return true;
+}
+
+void IndirectRenderer::PrepareDirectDraw()
+{
+	//Same as Add, a push into a new region can't happen while ids from the old one are still queued
+	if (_drawData != nullptr && _drawData->GetRemaining() == 0)
+		Flush();
+}
+
+void IndirectRenderer::End()
+{
+	Flush();
+	_applyMaterial = nullptr;
+}
+
+size_t IndirectRenderer::GetBatchCount() const
+{
+	return _batchCount;
+}
+
+size_t IndirectRenderer::GetCommandCount() const
+{
+	return _commandCount;
+}
+
+void IndirectRenderer::Flush()
+{
+	if (_commands.empty())
+		return;
+
+	//Orphan the old commands rather than waiting on draws that still read them
+	size_t size = _commands.size() * sizeof(DrawElementsIndirectCommand);
+	if (size > _commandCapacity)
+		_commandCapacity = size * 2;
+	glNamedBufferData(_commandBuffer, _commandCapacity, nullptr, GL_STREAM_DRAW);
+	glNamedBufferSubData(_commandBuffer, 0, size, _commands.data());
+
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, _commandBuffer);
+	GLStateCache::BindVertexArray(_pool->GetVAO());
+	for (const Batch& batch : _batches)
+	{
+		_applyMaterial(batch.Material);
+		const void* offset = reinterpret_cast<const void*>(batch.FirstCommand * sizeof(DrawElementsIndirectCommand));
+		glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, offset, GLsizei(batch.CommandCount), 0);
+	}
+	GLStateCache::BindVertexArray(GL_NONE);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, GL_NONE);
+
+	_batchCount += _batches.size();
+	_commandCount += _commands.size();
+	_commands.clear();
+	_batches.clear();
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include <functional>
+#include <vector>
+#include <glad/glad.h>
+#include <GLM/glm.hpp>
+#include <ShaderMaterial.h>
+#include <Transform.h>
+
+#include "Graphics/MeshPool.h"
+#include "Graphics/DrawDataBuffer.h"
+#include "Graphics/GLStateCache.h"
+
+//Layout glMultiDrawElementsIndirect reads commands in
+struct DrawElementsIndirectCommand
+{
+	GLuint Count;
+	GLuint InstanceCount;
+	GLuint FirstIndex;
+	GLint BaseVertex;
+	//Doubles as the draw id, see IndirectRenderer
+	GLuint BaseInstance;
+};
+
+//Draws pooled meshes with one glMultiDrawElementsIndirect per material
+//*Renderers are added in draw order (see RenderQueue), back to back renderers with the same material share a batch
+//*Each command's base instance is its draw id, and the pool VAO feeds location 8 from a buffer of 0, 1, 2... with a divisor of 1,
+//so inDrawId comes out as the draw id without needing gl_DrawID
+class IndirectRenderer
+{
+public:
+	//Vertex buffer binding of the draw id buffer on the pool VAO
+	static const GLuint DRAW_ID_BINDING = 1;
+
+	//Binds the material (and its shader) before a batch is drawn
+	typedef std::function<void(const ShaderMaterial::sptr&)> ApplyMaterialFunc;
+
+	IndirectRenderer();
+	//Deconstructor
+	//*Deletes the command and draw id buffers
+	~IndirectRenderer();
+
+	IndirectRenderer(const IndirectRenderer& other) = delete;
+	IndirectRenderer& operator=(const IndirectRenderer& other) = delete;
+
+	//Hooks the draw id buffer up to the pool's VAO, draws go into drawData
+	void Init(MeshPool& pool, DrawDataBuffer& drawData);
+	//Deletes the command and draw id buffers
+	void Unload();
+
+	//Starts collecting draws
+	void Begin(const ApplyMaterialFunc& applyMaterial);
+	//Adds a draw of mesh, returns false if the mesh isn't pooled so the caller has to draw it normally
+	bool Add(const ShaderMaterial::sptr& material, const VertexArrayObject::sptr& mesh, const glm::mat4& viewProjection, const Transform& transform);
+	//Draws the batches added so far, so anything drawn after them (like a later render layer) really is drawn after
+	//*Also called when the draw data buffer is about to move to a new region, since that would change what the ids point at
+	void Flush();
+	//Call before a draw that pushes to the draw data buffer itself (like BackendHandler::RenderVAO), and before applying its material
+	//*If that push would start a new region the queued batches are flushed first, same as in Add
+	void PrepareDirectDraw();
+	//Draws everything added since Begin
+	void End();
+
+	//Getters
+	//Multi draws issued by the last Begin / End
+	size_t GetBatchCount() const;
+	//Meshes drawn by the last Begin / End
+	size_t GetCommandCount() const;
+
+private:
+	struct Batch
+	{
+		ShaderMaterial::sptr Material;
+		size_t FirstCommand;
+		size_t CommandCount;
+	};
+
+	MeshPool* _pool = nullptr;
+	DrawDataBuffer* _drawData = nullptr;
+	ApplyMaterialFunc _applyMaterial;
+
+	GLuint _commandBuffer = GL_NONE;
+	size_t _commandCapacity = 0;
+	GLuint _drawIdBuffer = GL_NONE;
+
+	std::vector<DrawElementsIndirectCommand> _commands;
+	std::vector<Batch> _batches;
+
+	size_t _batchCount = 0;
+	size_t _commandCount = 0;
+};
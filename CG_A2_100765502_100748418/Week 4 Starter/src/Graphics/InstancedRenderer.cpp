@@ -0,0 +1,82 @@
+#include "InstancedRenderer.h"
+
+#include <utility>
+
+InstancedRenderer::InstancedRenderer()
+{
+}
+
+InstancedRenderer::~InstancedRenderer()
+{
+	if (_instanceBuffer != GL_NONE)
+		glDeleteBuffers(1, &_instanceBuffer);
+}
+
+InstancedRenderer::InstancedRenderer(InstancedRenderer&& other) noexcept
+{
+	*this = std::move(other);
+}
+
+InstancedRenderer& InstancedRenderer::operator=(InstancedRenderer&& other) noexcept
+{
+	std::swap(Mesh, other.Mesh);
+	std::swap(Material, other.Material);
+	std::swap(_instanceBuffer, other._instanceBuffer);
+	std::swap(_instanceCount, other._instanceCount);
+	return *this;
+}
+
+InstancedRenderer& InstancedRenderer::SetMesh(const VertexArrayObject::sptr& mesh)
+{
+	Mesh = mesh;
+	return *this;
+}
+
+InstancedRenderer& InstancedRenderer::SetMaterial(const ShaderMaterial::sptr& material)
+{
+	Material = material;
+	return *this;
+}
+
+InstancedRenderer& InstancedRenderer::SetInstances(const std::vector<glm::mat4>& transforms)
+{
+	if (_instanceBuffer == GL_NONE)
+		glCreateBuffers(1, &_instanceBuffer);
+
+	//Spawns don't move, so this is written once and drawn from every frame
+	_instanceCount = transforms.size();
+	glNamedBufferData(_instanceBuffer, _instanceCount * sizeof(glm::mat4), transforms.data(), GL_STATIC_DRAW);
+	return *this;
+}
+
+void InstancedRenderer::Render(const Shader::sptr& shader) const
+{
+	if (Mesh == nullptr || _instanceCount == 0)
+		return;
+
+	GLuint vao = Mesh->GetHandle();
+
+	//The mesh can be shared with other renderers, so point it at this instance buffer every draw
+	glVertexArrayVertexBuffer(vao, INSTANCE_BINDING, _instanceBuffer, 0, sizeof(glm::mat4));
+	glVertexArrayBindingDivisor(vao, INSTANCE_BINDING, 1);
+	for (GLuint i = 0; i < 4; i++)
+	{
+		glEnableVertexArrayAttrib(vao, INSTANCE_ATTRIBUTE + i);
+		glVertexArrayAttribFormat(vao, INSTANCE_ATTRIBUTE + i, 4, GL_FLOAT, GL_FALSE, i * sizeof(glm::vec4));
+		glVertexArrayAttribBinding(vao, INSTANCE_ATTRIBUTE + i, INSTANCE_BINDING);
+	}
+
+	shader->SetUniform("u_Instanced", 1);
+	GLStateCache::BindVertexArray(vao);
+	if (Mesh->GetIndexBuffer() != nullptr)
+		glDrawElementsInstanced(GL_TRIANGLES, Mesh->GetIndexBuffer()->GetElementCount(), Mesh->GetIndexBuffer()->GetElementType(), nullptr, GLsizei(_instanceCount));
+	else
+		glDrawArraysInstanced(GL_TRIANGLES, 0, Mesh->GetVertexCount(), GLsizei(_instanceCount));
+	GLStateCache::BindVertexArray(GL_NONE);
+	shader->SetUniform("u_Instanced", 0);
+}
+
+size_t InstancedRenderer::GetInstanceCount() const
+{
+	return _instanceCount;
+}
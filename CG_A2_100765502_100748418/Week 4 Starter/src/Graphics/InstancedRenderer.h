@@ -0,0 +1,48 @@
+#pragma once
+#include <vector>
+#include <glad/glad.h>
+#include <GLM/glm.hpp>
+#include <VertexArrayObject.h>
+#include <ShaderMaterial.h>
+
+#include "Graphics/GLStateCache.h"
+
+//Draws one mesh many times in a single draw call
+//*Each instance's model matrix lives in a per-instance buffer that feeds inInstanceModel in vertex_shader
+class InstancedRenderer
+{
+public:
+	//Attribute locations the model matrix takes up (one per column, 4 - 7)
+	static const GLuint INSTANCE_ATTRIBUTE = 4;
+	//Vertex buffer binding the instance buffer goes in, kept clear of the mesh's own bindings
+	static const GLuint INSTANCE_BINDING = 15;
+
+	InstancedRenderer();
+	//Deconstructor
+	//*Deletes the instance buffer
+	~InstancedRenderer();
+
+	//The instance buffer can only have one owner, but the scene needs to be able to move components around
+	InstancedRenderer(const InstancedRenderer& other) = delete;
+	InstancedRenderer& operator=(const InstancedRenderer& other) = delete;
+	InstancedRenderer(InstancedRenderer&& other) noexcept;
+	InstancedRenderer& operator=(InstancedRenderer&& other) noexcept;
+
+	InstancedRenderer& SetMesh(const VertexArrayObject::sptr& mesh);
+	InstancedRenderer& SetMaterial(const ShaderMaterial::sptr& material);
+	//Uploads the model matrix of every instance
+	InstancedRenderer& SetInstances(const std::vector<glm::mat4>& transforms);
+
+	//Draws every instance with the shader (which should already be bound with its material applied)
+	void Render(const Shader::sptr& shader) const;
+
+	//Getters
+	size_t GetInstanceCount() const;
+
+	VertexArrayObject::sptr Mesh;
+	ShaderMaterial::sptr Material;
+
+private:
+	GLuint _instanceBuffer = GL_NONE;
+	size_t _instanceCount = 0;
+};
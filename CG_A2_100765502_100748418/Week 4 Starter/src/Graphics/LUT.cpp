@@ -1,67 +1,601 @@
 #include "LUT.h"
+
+#include <filesystem>
+#include <cstring>
+#include <cstdio>
+#include <Logging.h>
+
+#include "Utilities/MappedFile.h"
+#include "Utilities/Util.h"
+
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__SSE2__)
+#define LUT_USE_SSE2
+#include <emmintrin.h>
+#endif
+
 #pragma warning(disable : 4996)
+
+std::string LUT3D::cacheDirectory = "cubes/cache/";
+std::unordered_map<uint64_t, LUT3D::LoadedLUT> LUT3D::_loadedLUTs;
+
+namespace
+{
+	//Powers of ten that are exactly representable as doubles
+	const double powersOfTen[] =
+	{
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+
+	bool isSpace(char c)
+	{
+		return c == ' ' || c == '\t' || c == '\r';
+	}
+
+	const char* skipSpaces(const char* p, const char* end)
+	{
+		while (p < end && isSpace(*p))
+			p++;
+		return p;
+	}
+
+	//Scans a decimal float starting at p (like from_chars)
+	//*Returns the character after the number, or nullptr if there wasn't one
+	const char* scanFloat(const char* p, const char* end, float& out)
+	{
+		bool negative = false;
+		if (p < end && (*p == '-' || *p == '+'))
+		{
+			negative = *p == '-';
+			p++;
+		}
+
+		//Collect up to 19 significant digits into an integer mantissa
+		uint64_t mantissa = 0;
+		int digits = 0;
+		int exponent = 0;
+		bool anyDigits = false;
+
+		while (p < end && *p >= '0' && *p <= '9')
+		{
+			if (digits < 19)
+			{
+				mantissa = mantissa * 10 + uint64_t(*p - '0');
+				if (mantissa != 0)
+					digits++;
+			}
+			else
+				exponent++;
+			anyDigits = true;
+			p++;
+		}
+
+		if (p < end && *p == '.')
+		{
+			p++;
+			while (p < end && *p >= '0' && *p <= '9')
+			{
+				if (digits < 19)
+				{
+					mantissa = mantissa * 10 + uint64_t(*p - '0');
+					if (mantissa != 0)
+						digits++;
+					exponent--;
+				}
+				anyDigits = true;
+				p++;
+			}
+		}
+
+		if (!anyDigits)
+			return nullptr;
+
+		if (p < end && (*p == 'e' || *p == 'E'))
+		{
+			const char* e = p + 1;
+			bool negativeExponent = false;
+			if (e < end && (*e == '-' || *e == '+'))
+			{
+				negativeExponent = *e == '-';
+				e++;
+			}
+
+			//Only treat it as an exponent if digits follow
+			if (e < end && *e >= '0' && *e <= '9')
+			{
+				int value = 0;
+				while (e < end && *e >= '0' && *e <= '9')
+				{
+					if (value < 10000)
+						value = value * 10 + (*e - '0');
+					e++;
+				}
+				exponent += negativeExponent ? -value : value;
+				p = e;
+			}
+		}
+
+		double result = double(mantissa);
+		if (exponent < 0)
+		{
+			while (exponent < -22)
+			{
+				result /= 1e22;
+				exponent += 22;
+			}
+			result /= powersOfTen[-exponent];
+		}
+		else
+		{
+			while (exponent > 22)
+			{
+				result *= 1e22;
+				exponent -= 22;
+			}
+			result *= powersOfTen[exponent];
+		}
+
+		out = float(negative ? -result : result);
+		return p;
+	}
+
+	//Scans three floats separated by whitespace
+	const char* scanVec3(const char* p, const char* end, glm::vec3& out)
+	{
+		for (int i = 0; i < 3 && p != nullptr; i++)
+			p = scanFloat(skipSpaces(p, end), end, out[i]);
+		return p;
+	}
+
+	//Scans an unsigned whole number starting at p
+	//*Returns the character after the number, or nullptr if there wasn't one or it doesn't fit
+	const char* scanUnsigned(const char* p, const char* end, unsigned& out)
+	{
+		uint64_t value = 0;
+		const char* start = p;
+		while (p < end && *p >= '0' && *p <= '9')
+		{
+			value = value * 10 + uint64_t(*p - '0');
+			if (value > 0xFFFFFFFFull)
+				return nullptr;
+			p++;
+		}
+
+		if (p == start)
+			return nullptr;
+		out = unsigned(value);
+		return p;
+	}
+
+	//Converts one float to a half (round to nearest even, flushes denormals, clamps to the largest half)
+	uint16_t floatToHalf(float value)
+	{
+		uint32_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+		uint32_t sign = (bits >> 16) & 0x8000u;
+		uint32_t absolute = bits & 0x7FFFFFFFu;
+
+		if (absolute < 0x38800000u)
+			return uint16_t(sign);
+		if (absolute >= 0x477FF000u)
+			return uint16_t(sign | 0x7BFFu);
+
+		absolute += 0x0FFFu + ((absolute >> 13) & 1u);
+		return uint16_t(sign | ((absolute >> 13) - (112u << 10)));
+	}
+
+	//Converts count floats to halves, four at a time
+	void convertToHalf(const float* in, uint16_t* out, size_t count)
+	{
+		size_t i = 0;
+#ifdef LUT_USE_SSE2
+		const __m128i signMask = _mm_set1_epi32(int(0x80000000u));
+		const __m128i minNormal = _mm_set1_epi32(0x38800000);
+		const __m128i maxHalf = _mm_set1_epi32(0x477FF000 - 1);
+		const __m128i maxHalfBits = _mm_set1_epi32(0x7BFF);
+		const __m128i roundBias = _mm_set1_epi32(0x0FFF);
+		const __m128i one = _mm_set1_epi32(1);
+		const __m128i rebias = _mm_set1_epi32(112 << 10);
+
+		for (; i + 8 <= count; i += 8)
+		{
+			__m128i halves[2];
+			for (int j = 0; j < 2; j++)
+			{
+				__m128i bits = _mm_castps_si128(_mm_loadu_ps(in + i + j * 4));
+				__m128i sign = _mm_srli_epi32(_mm_and_si128(bits, signMask), 16);
+				__m128i absolute = _mm_andnot_si128(signMask, bits);
+
+				//Same rounding as floatToHalf, done on all four lanes
+				__m128i rounded = _mm_add_epi32(absolute, _mm_add_epi32(roundBias, _mm_and_si128(_mm_srli_epi32(absolute, 13), one)));
+				__m128i half = _mm_sub_epi32(_mm_srli_epi32(rounded, 13), rebias);
+
+				//Too small becomes zero, too big becomes the largest half
+				__m128i tooSmall = _mm_cmplt_epi32(absolute, minNormal);
+				__m128i tooBig = _mm_cmpgt_epi32(absolute, maxHalf);
+				half = _mm_andnot_si128(tooSmall, half);
+				half = _mm_or_si128(_mm_andnot_si128(tooBig, half), _mm_and_si128(tooBig, maxHalfBits));
+
+				//Sign extend from 16 bits so the signed pack below keeps the bits as they are
+				half = _mm_or_si128(half, sign);
+				halves[j] = _mm_srai_epi32(_mm_slli_epi32(half, 16), 16);
+			}
+
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packs_epi32(halves[0], halves[1]));
+		}
+#endif
+		for (; i < count; i++)
+			out[i] = floatToHalf(in[i]);
+	}
+
+	//Converts count RGB texels to RGBA8 with full alpha
+	void convertToRGBA8(const float* in, uint32_t* out, size_t count)
+	{
+		size_t i = 0;
+#ifdef LUT_USE_SSE2
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 scale = _mm_set1_ps(255.0f);
+
+		//Loads 4 floats per texel, so the last texel is done below to avoid reading past the end
+		for (; i + 1 < count; i++)
+		{
+			__m128 rgb = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i * 3), zero), _mm_set1_ps(1.0f));
+			__m128i channels = _mm_cvtps_epi32(_mm_mul_ps(rgb, scale));
+			__m128i bytes = _mm_packus_epi16(_mm_packs_epi32(channels, channels), channels);
+			out[i] = (uint32_t(_mm_cvtsi128_si32(bytes)) & 0x00FFFFFFu) | 0xFF000000u;
+		}
+#endif
+		for (; i < count; i++)
+		{
+			uint32_t texel = 0xFF000000u;
+			for (int c = 0; c < 3; c++)
+			{
+				float value = in[i * 3 + c] < 0.0f ? 0.0f : (in[i * 3 + c] > 1.0f ? 1.0f : in[i * 3 + c]);
+				texel |= uint32_t(value * 255.0f + 0.5f) << (c * 8);
+			}
+			out[i] = texel;
+		}
+	}
+
+	//Converts count RGB texels to 10/10/10/2 with full alpha
+	void convertToRGB10A2(const float* in, uint32_t* out, size_t count)
+	{
+		size_t i = 0;
+#ifdef LUT_USE_SSE2
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 scale = _mm_set1_ps(1023.0f);
+		//Moves each channel to its bit offset, the 4th lane is the neighbouring texel so it's dropped
+		const __m128 shift = _mm_set_ps(0.0f, 1048576.0f, 1024.0f, 1.0f);
+
+		for (; i + 1 < count; i++)
+		{
+			__m128 rgb = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i * 3), zero), _mm_set1_ps(1.0f));
+			//Round to integers first so the shifted values are exact
+			__m128 rounded = _mm_cvtepi32_ps(_mm_cvtps_epi32(_mm_mul_ps(rgb, scale)));
+			__m128i shifted = _mm_cvtps_epi32(_mm_mul_ps(rounded, shift));
+
+			//Bits don't overlap so adding the lanes together packs them
+			shifted = _mm_add_epi32(shifted, _mm_shuffle_epi32(shifted, _MM_SHUFFLE(1, 0, 3, 2)));
+			shifted = _mm_add_epi32(shifted, _mm_shuffle_epi32(shifted, _MM_SHUFFLE(2, 3, 0, 1)));
+			out[i] = uint32_t(_mm_cvtsi128_si32(shifted)) | 0xC0000000u;
+		}
+#endif
+		for (; i < count; i++)
+		{
+			uint32_t texel = 0xC0000000u;
+			for (int c = 0; c < 3; c++)
+			{
+				float value = in[i * 3 + c] < 0.0f ? 0.0f : (in[i * 3 + c] > 1.0f ? 1.0f : in[i * 3 + c]);
+				texel |= uint32_t(value * 1023.0f + 0.5f) << (c * 10);
+			}
+			out[i] = texel;
+		}
+	}
+
+	//Bytes per texel on the GPU for each precision
+	//*RGB16F is padded to four channels by most drivers
+	size_t bytesPerTexel(LUTPrecision precision)
+	{
+		return precision == LUTPrecision::RGB16F ? 8 : 4;
+	}
+
+	//Does the line at p start with the keyword?
+	bool startsWith(const char* p, const char* end, const char* keyword)
+	{
+		size_t length = strlen(keyword);
+		return size_t(end - p) > length && memcmp(p, keyword, length) == 0 && isSpace(p[length]);
+	}
+}
+
 LUT3D::LUT3D()
 {
 }
 
-LUT3D::LUT3D(std::string path)
+LUT3D::LUT3D(std::string path, LUTPrecision precision)
 {
-	loadFromFile(path);
+	loadFromFile(path, precision);
 }
 
-void LUT3D::loadFromFile(std::string path)
+void LUT3D::loadFromFile(std::string path, LUTPrecision precision)
 {
-	std::string filePath = path;
-	std::ifstream LUTstream;
-	LUTstream.open(filePath);
+	_precision = precision;
 
-	while (!LUTstream.eof())
+	//Map the .cube, we only need the bytes to hash them unless there's no compiled version
+	MappedFile cube;
+	if (!cube.Open(path))
 	{
-		std::string _line;
-		std::getline(LUTstream, _line);
+		LOG_ERROR("Failed to open LUT {}", path);
+		return;
+	}
+
+	uint64_t hash = Util::HashBytes(cube.GetData(), cube.GetSize());
+	//The same cube at a different precision is a different texture
+	uint64_t textureKey = Util::HashBytes(&precision, sizeof(precision), hash);
+
+	//Same contents already uploaded? share the texture
+	auto loaded = _loadedLUTs.find(textureKey);
+	if (loaded != _loadedLUTs.end())
+	{
+		_handle = loaded->second.Handle;
+		_size = loaded->second.Size;
+		_domainMin = loaded->second.DomainMin;
+		_domainMax = loaded->second.DomainMax;
+		_title = loaded->second.Title;
+		return;
+	}
+
+	char hashName[17];
+	snprintf(hashName, sizeof(hashName), "%016llx", (unsigned long long)hash);
+	std::string cachePath = cacheDirectory + hashName + ".lutbin";
+
+	//Fall back to parsing the text, then compile it so next launch can skip this
+	if (!loadCompiled(cachePath, hash))
+	{
+		if (!parseCube(cube.GetData(), cube.GetSize()))
+		{
+			LOG_ERROR("LUT {} is not a valid 3D .cube", path);
+			data.clear();
+			return;
+		}
+
+		writeCompiled(cachePath, hash);
+		upload(&data[0].x, _size);
+		releaseData();
+	}
+
+	_loadedLUTs[textureKey] = { _handle, _size, _domainMin, _domainMax, _title };
+}
+
+bool LUT3D::parseCube(const char* text, size_t length)
+{
+	data.clear();
+	_size = 0;
+	_domainMin = glm::vec3(0.0f);
+	_domainMax = glm::vec3(1.0f);
+	_title.clear();
+
+	const char* end = text + length;
+	while (text < end)
+	{
+		//Find the end of this line
+		const char* lineEnd = static_cast<const char*>(memchr(text, '\n', end - text));
+		if (lineEnd == nullptr)
+			lineEnd = end;
 
-		if (_line.empty())
+		const char* p = skipSpaces(text, lineEnd);
+		text = lineEnd + 1;
+
+		//Blank lines and comments
+		if (p == lineEnd || *p == '#')
 			continue;
 
 		glm::vec3 lineData;
-		if (sscanf(_line.c_str(), "%f %f %f", &lineData.x, &lineData.y, &lineData.z) == 3)
+		if ((*p >= '0' && *p <= '9') || *p == '-' || *p == '+' || *p == '.')
+		{
+			//Table entry, red changes fastest which matches the texture layout
+			if (scanVec3(p, lineEnd, lineData) == nullptr)
+				return false;
 			data.push_back(lineData);
+		}
+		else if (startsWith(p, lineEnd, "LUT_3D_SIZE"))
+		{
+			//Has to be a whole number, anything left on the line (like the .5 in 33.5) makes it invalid
+			unsigned size = 0;
+			const char* after = scanUnsigned(skipSpaces(p + 11, lineEnd), lineEnd, size);
+			if (after == nullptr || skipSpaces(after, lineEnd) != lineEnd || size < 2 || size > 256)
+				return false;
+			_size = size;
+			data.reserve(size_t(_size) * _size * _size);
+		}
+		else if (startsWith(p, lineEnd, "DOMAIN_MIN"))
+		{
+			if (scanVec3(p + 10, lineEnd, _domainMin) == nullptr)
+				return false;
+		}
+		else if (startsWith(p, lineEnd, "DOMAIN_MAX"))
+		{
+			if (scanVec3(p + 10, lineEnd, _domainMax) == nullptr)
+				return false;
+		}
+		else if (startsWith(p, lineEnd, "TITLE"))
+		{
+			//Title is quoted
+			const char* first = static_cast<const char*>(memchr(p, '"', lineEnd - p));
+			const char* last = first ? static_cast<const char*>(memchr(first + 1, '"', lineEnd - first - 1)) : nullptr;
+			if (first && last)
+				_title.assign(first + 1, last);
+		}
+		else if (startsWith(p, lineEnd, "LUT_1D_SIZE"))
+		{
+			//1D LUTs can't go in a 3D texture
+			return false;
+		}
+		//Anything else is a keyword we don't use
+	}
+
+	//Older files without a size header, work it out from the number of entries
+	if (_size == 0)
+	{
+		while (size_t(_size + 1) * (_size + 1) * (_size + 1) <= data.size())
+			_size++;
 	}
 
-	glEnable(GL_TEXTURE_3D);
+	return _size >= 2 && data.size() == size_t(_size) * _size * _size;
+}
+
+void LUT3D::upload(const float* texels, unsigned size)
+{
+	size_t count = size_t(size) * size * size;
+
+	//Convert on our side so the driver doesn't have to pick a format and convert for us
+	std::vector<uint32_t> converted;
+	GLenum internalFormat, format, type;
+	switch (_precision)
+	{
+	case LUTPrecision::RGB10_A2:
+		converted.resize(count);
+		convertToRGB10A2(texels, converted.data(), count);
+		internalFormat = GL_RGB10_A2;
+		format = GL_RGBA;
+		type = GL_UNSIGNED_INT_2_10_10_10_REV;
+		break;
+	case LUTPrecision::RGBA8:
+		converted.resize(count);
+		convertToRGBA8(texels, converted.data(), count);
+		internalFormat = GL_RGBA8;
+		format = GL_RGBA;
+		type = GL_UNSIGNED_BYTE;
+		break;
+	case LUTPrecision::RGB16F:
+	default:
+		//Three halves per texel, rounded up to whole uint32s
+		converted.resize((count * 3 + 1) / 2);
+		convertToHalf(texels, reinterpret_cast<uint16_t*>(converted.data()), count * 3);
+		internalFormat = GL_RGB16F;
+		format = GL_RGB;
+		type = GL_HALF_FLOAT;
+		break;
+	}
+
+	//Created rather than bound, so no texture unit gets changed behind GLStateCache
+	glCreateTextures(GL_TEXTURE_3D, 1, &_handle);
+	glTextureParameteri(_handle, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTextureParameteri(_handle, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTextureParameteri(_handle, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTextureParameteri(_handle, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTextureParameteri(_handle, GL_TEXTURE_WRAP_R, GL_REPEAT);
+
+	//Half float rows are 6 bytes a texel so they aren't always 4 byte aligned
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTextureStorage3D(_handle, 1, internalFormat, size, size, size);
+	glTextureSubImage3D(_handle, 0, 0, 0, 0, size, size, size, format, type, converted.data());
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+void LUT3D::releaseData()
+{
+	//Swap with an empty vector so the memory is actually given back
+	std::vector<glm::vec3>().swap(data);
+}
+
+bool LUT3D::loadCompiled(const std::string& cachePath, uint64_t hash)
+{
+	MappedFile compiled;
+	if (!compiled.Open(cachePath) || compiled.GetSize() < sizeof(LUTBinaryHeader))
+		return false;
+
+	//Make sure this is a compiled LUT of the version we write, made from this exact .cube
+	LUTBinaryHeader header;
+	memcpy(&header, compiled.GetData(), sizeof(LUTBinaryHeader));
+	header.Title[sizeof(header.Title) - 1] = '\0';
+	LUTBinaryHeader expected;
+	size_t texelBytes = size_t(header.Size) * header.Size * header.Size * sizeof(glm::vec3);
+	if (memcmp(header.Magic, expected.Magic, sizeof(header.Magic)) != 0 || header.Version != expected.Version ||
+		header.Hash != hash || compiled.GetSize() != sizeof(LUTBinaryHeader) + texelBytes)
+		return false;
 
-	glGenTextures(1, &_handle);
-	bind();
-	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_REPEAT);
+	_size = header.Size;
+	_domainMin = glm::vec3(header.DomainMin[0], header.DomainMin[1], header.DomainMin[2]);
+	_domainMax = glm::vec3(header.DomainMax[0], header.DomainMax[1], header.DomainMax[2]);
+	_title = header.Title;
+
+	//The texels go straight from the mapped pages to the driver
+	upload(reinterpret_cast<const float*>(compiled.GetData() + sizeof(LUTBinaryHeader)), header.Size);
+	return true;
+}
+
+void LUT3D::writeCompiled(const std::string& cachePath, uint64_t hash)
+{
+	std::error_code error;
+	std::filesystem::create_directories(cacheDirectory, error);
 
-	glTexImage3D(GL_TEXTURE_3D, 0, GL_RGB, 64, 64, 64, 0, GL_RGB, GL_FLOAT, &data[0]);
-	unbind();
+	std::ofstream compiled(cachePath, std::ios::binary);
+	if (!compiled)
+	{
+		LOG_WARN("Could not write compiled LUT {}", cachePath);
+		return;
+	}
 
-	glDisable(GL_TEXTURE_3D);
+	LUTBinaryHeader header;
+	header.Hash = hash;
+	header.Size = _size;
+	for (int i = 0; i < 3; i++)
+	{
+		header.DomainMin[i] = _domainMin[i];
+		header.DomainMax[i] = _domainMax[i];
+	}
+	strncpy(header.Title, _title.c_str(), sizeof(header.Title) - 1);
+	compiled.write(reinterpret_cast<const char*>(&header), sizeof(LUTBinaryHeader));
+	compiled.write(reinterpret_cast<const char*>(&data[0]), data.size() * sizeof(glm::vec3));
 }
 
 void LUT3D::bind()
 {
-	glBindTexture(GL_TEXTURE_3D, _handle);
+	bind(0);
 }
 
 void LUT3D::unbind()
 {
-	glBindTexture(GL_TEXTURE_3D, GL_NONE);
+	unbind(0);
 }
 
 void LUT3D::bind(int textureSlot)
 {
-	glActiveTexture(GL_TEXTURE0 + textureSlot);
-	bind();
+	GLStateCache::BindTexture(textureSlot, _handle);
 }
 
 void LUT3D::unbind(int textureSlot)
 {
-	glActiveTexture(GL_TEXTURE0 + textureSlot);
-	unbind();
-}
\ No newline at end of file
+	GLStateCache::BindTexture(textureSlot, GL_NONE);
+}
+
+unsigned LUT3D::getSize() const
+{
+	return _size;
+}
+
+glm::vec3 LUT3D::getDomainMin() const
+{
+	return _domainMin;
+}
+
+glm::vec3 LUT3D::getDomainMax() const
+{
+	return _domainMax;
+}
+
+const std::string& LUT3D::getTitle() const
+{
+	return _title;
+}
+
+LUTPrecision LUT3D::getPrecision() const
+{
+	return _precision;
+}
+
+size_t LUT3D::getResidentBytes() const
+{
+	size_t gpuBytes = _handle ? size_t(_size) * _size * _size * bytesPerTexel(_precision) : 0;
+	return gpuBytes + data.capacity() * sizeof(glm::vec3);
+}
@@ -2,21 +2,106 @@
 #include <vector>
 #include <fstream>
 #include <string>
+#include <unordered_map>
+#include <cstdint>
 #include <glad/glad.h>
 #include "glm/common.hpp"
 
+#include "Graphics/GLStateCache.h"
+
+//Header at the start of a compiled (binary) LUT
+//*Followed by size^3 RGB float texels, ready for glTexImage3D
+struct LUTBinaryHeader
+{
+	char Magic[4] = { 'L', 'U', 'T', 'B' };
+	uint32_t Version = 2;
+	//Content hash of the .cube this was compiled from
+	uint64_t Hash = 0;
+	//Number of texels along each axis
+	uint32_t Size = 0;
+	uint32_t Reserved = 0;
+	//Input range the LUT covers
+	float DomainMin[3] = { 0.0f, 0.0f, 0.0f };
+	float DomainMax[3] = { 1.0f, 1.0f, 1.0f };
+	//TITLE from the .cube, null terminated
+	char Title[64] = {};
+};
+
+//How the LUT texels are stored on the GPU
+enum class LUTPrecision
+{
+	//16 bit float per channel
+	RGB16F,
+	//10 bits per colour channel, packed into 32 bits
+	RGB10_A2,
+	//8 bits per channel
+	RGBA8
+};
+
 class LUT3D
 {
 public:
 	LUT3D();
-	LUT3D(std::string path);
-	void loadFromFile(std::string path);
+	LUT3D(std::string path, LUTPrecision precision = LUTPrecision::RGB16F);
+
+	//A LUT owns its texture handle, share it through a pointer instead of copying
+	LUT3D(const LUT3D& other) = delete;
+	LUT3D& operator=(const LUT3D& other) = delete;
+
+	void loadFromFile(std::string path, LUTPrecision precision = LUTPrecision::RGB16F);
+	//Slot 0
 	void bind();
 	void unbind();
 
 	void bind(int textureSlot);
 	void unbind(int textureSlot);
+
+	//Getters
+	unsigned getSize() const;
+	glm::vec3 getDomainMin() const;
+	glm::vec3 getDomainMax() const;
+	const std::string& getTitle() const;
+	LUTPrecision getPrecision() const;
+	//Bytes this LUT keeps alive on the GPU and CPU
+	size_t getResidentBytes() const;
+
+	//Folder that compiled LUTs are written to and mapped from
+	static std::string cacheDirectory;
 private:
+	//Parses the header and table of a .cube file into data
+	//*Returns false if the file isn't a valid 3D LUT
+	bool parseCube(const char* text, size_t length);
+	//Converts size^3 RGB floats to _precision and creates the 3D texture from them
+	void upload(const float* texels, unsigned size);
+	//Frees the parsed texels once they're on the GPU
+	void releaseData();
+
+	//Tries to map and upload a compiled LUT, returns false if there isn't a valid one
+	bool loadCompiled(const std::string& cachePath, uint64_t hash);
+	//Writes data out as a compiled LUT
+	void writeCompiled(const std::string& cachePath, uint64_t hash);
+
 	GLuint _handle = GL_NONE;
 	std::vector<glm::vec3> data;
-};
\ No newline at end of file
+
+	//Texels along each axis (LUT_3D_SIZE)
+	unsigned _size = 0;
+	//Input range (DOMAIN_MIN / DOMAIN_MAX)
+	glm::vec3 _domainMin = glm::vec3(0.0f);
+	glm::vec3 _domainMax = glm::vec3(1.0f);
+	//Name of the LUT (TITLE)
+	std::string _title;
+	//Storage format of the texture
+	LUTPrecision _precision = LUTPrecision::RGB16F;
+
+	//LUTs uploaded so far this run, keyed by the content hash of their .cube and the precision
+	struct LoadedLUT
+	{
+		GLuint Handle;
+		unsigned Size;
+		glm::vec3 DomainMin;
+		glm::vec3 DomainMax;
+		std::string Title;
+	};
+	static std::unordered_map<uint64_t, LoadedLUT> _loadedLUTs;
+};
@@ -0,0 +1,215 @@
+#include "LightClusters.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+
+LightClusters::LightClusters()
+{
+}
+
+LightClusters::~LightClusters()
+{
+	Unload();
+}
+
+void LightClusters::Init()
+{
+	CreateBuffer(_lightBuffer, GL_RGBA32F);
+	CreateBuffer(_gridBuffer, GL_RG32UI);
+	CreateBuffer(_indexBuffer, GL_R32UI);
+
+	_grid.resize(TILES_X * TILES_Y * SLICES * 2);
+}
+
+void LightClusters::Unload()
+{
+	for (TextureBuffer* buffer : { &_lightBuffer, &_gridBuffer, &_indexBuffer })
+	{
+		if (buffer->Texture != GL_NONE)
+		{
+			GLStateCache::ForgetTexture(buffer->Texture);
+			glDeleteTextures(1, &buffer->Texture);
+			glDeleteBuffers(1, &buffer->Buffer);
+			buffer->Texture = GL_NONE;
+			buffer->Buffer = GL_NONE;
+		}
+	}
+}
+
+void LightClusters::Update(const std::vector<PointLight>& lights, const glm::mat4& view, const glm::mat4& projection, unsigned width, unsigned height)
+{
+	_width = std::max(width, 1u);
+	_height = std::max(height, 1u);
+
+	//Pull the clip planes back out of the projection
+	if (projection[2][3] != 0.0f)
+	{
+		//Perspective
+		_near = projection[3][2] / (projection[2][2] - 1.0f);
+		_far = projection[3][2] / (projection[2][2] + 1.0f);
+	}
+	else
+	{
+		//Orthographic
+		_near = (projection[3][2] + 1.0f) / projection[2][2];
+		_far = (projection[3][2] - 1.0f) / projection[2][2];
+	}
+	//Depth slices are logarithmic so the near plane has to be in front of the camera
+	_near = std::max(_near, 0.01f);
+	_far = std::max(_far, _near + 0.01f);
+
+	size_t lightCount = std::min(lights.size(), size_t(MAX_LIGHTS));
+
+	_lightData.clear();
+	_ranges.clear();
+	_indices.clear();
+	std::fill(_grid.begin(), _grid.end(), 0u);
+
+	//Count how many lights land in each cluster
+	for (size_t i = 0; i < lightCount; i++)
+	{
+		ClusterRange range;
+		if (!GetClusterRange(lights[i], view, projection, range))
+			continue;
+
+		//Only lights that can be seen get uploaded
+		_lightData.push_back(glm::vec4(lights[i].Position, lights[i].Radius));
+		_lightData.push_back(glm::vec4(lights[i].Color * lights[i].Intensity, 0.0f));
+		_ranges.push_back(range);
+
+		for (int z = range.MinZ; z <= range.MaxZ; z++)
+			for (int y = range.MinY; y <= range.MaxY; y++)
+				for (int x = range.MinX; x <= range.MaxX; x++)
+					_grid[((z * TILES_Y + y) * TILES_X + x) * 2 + 1]++;
+	}
+
+	//Give each cluster its own run of the index list
+	uint32_t offset = 0;
+	_maxClusterLights = 0;
+	for (size_t i = 0; i < _grid.size(); i += 2)
+	{
+		_grid[i] = offset;
+		offset += _grid[i + 1];
+		_maxClusterLights = std::max(_maxClusterLights, _grid[i + 1]);
+		//Reset the count so it can be used to fill the run
+		_grid[i + 1] = 0;
+	}
+
+	//Fill the runs
+	_indices.resize(offset);
+	for (size_t i = 0; i < _ranges.size(); i++)
+	{
+		const ClusterRange& range = _ranges[i];
+		for (int z = range.MinZ; z <= range.MaxZ; z++)
+			for (int y = range.MinY; y <= range.MaxY; y++)
+				for (int x = range.MinX; x <= range.MaxX; x++)
+				{
+					uint32_t* cluster = &_grid[((z * TILES_Y + y) * TILES_X + x) * 2];
+					_indices[cluster[0] + cluster[1]] = uint32_t(i);
+					cluster[1]++;
+				}
+	}
+
+	UploadBuffer(_lightBuffer, _lightData.data(), _lightData.size() * sizeof(glm::vec4));
+	UploadBuffer(_gridBuffer, _grid.data(), _grid.size() * sizeof(uint32_t));
+	UploadBuffer(_indexBuffer, _indices.data(), _indices.size() * sizeof(uint32_t));
+}
+
+void LightClusters::Bind() const
+{
+	GLStateCache::BindTexture(LIGHT_SLOT, _lightBuffer.Texture);
+	GLStateCache::BindTexture(GRID_SLOT, _gridBuffer.Texture);
+	GLStateCache::BindTexture(INDEX_SLOT, _indexBuffer.Texture);
+}
+
+void LightClusters::Unbind() const
+{
+	GLStateCache::BindTexture(LIGHT_SLOT, GL_NONE);
+	GLStateCache::BindTexture(GRID_SLOT, GL_NONE);
+	GLStateCache::BindTexture(INDEX_SLOT, GL_NONE);
+}
+
+void LightClusters::ApplyUniforms(const Shader::sptr& shader) const
+{
+	shader->SetUniform("u_ClusterDims", glm::ivec3(TILES_X, TILES_Y, SLICES));
+	//Tiles per pixel
+	shader->SetUniform("u_ClusterTileScale", glm::vec2(float(TILES_X) / _width, float(TILES_Y) / _height));
+	//slice = log(depth) * scale + bias
+	float scale = SLICES / std::log(_far / _near);
+	shader->SetUniform("u_ClusterDepthParams", glm::vec2(scale, -std::log(_near) * scale));
+}
+
+size_t LightClusters::GetIndexCount() const
+{
+	return _indices.size();
+}
+
+unsigned LightClusters::GetMaxClusterLights() const
+{
+	return _maxClusterLights;
+}
+
+void LightClusters::CreateBuffer(TextureBuffer& buffer, GLenum format)
+{
+	glCreateBuffers(1, &buffer.Buffer);
+	//Texture buffers can't be empty
+	glNamedBufferData(buffer.Buffer, 16, nullptr, GL_STREAM_DRAW);
+	glCreateTextures(GL_TEXTURE_BUFFER, 1, &buffer.Texture);
+	glTextureBuffer(buffer.Texture, format, buffer.Buffer);
+}
+
+void LightClusters::UploadBuffer(const TextureBuffer& buffer, const void* data, size_t bytes)
+{
+	if (bytes == 0)
+		return;
+
+	//Respecifying the whole store lets the driver hand back fresh memory instead of waiting on last frame
+	glNamedBufferData(buffer.Buffer, bytes, data, GL_STREAM_DRAW);
+}
+
+bool LightClusters::GetClusterRange(const PointLight& light, const glm::mat4& view, const glm::mat4& projection, ClusterRange& range) const
+{
+	glm::vec3 viewPos = glm::vec3(view * glm::vec4(light.Position, 1.0f));
+	float depth = -viewPos.z;
+
+	//Outside the near / far planes
+	if (depth + light.Radius < _near || depth - light.Radius > _far)
+		return false;
+
+	range.MinZ = GetSlice(std::max(depth - light.Radius, _near));
+	range.MaxZ = GetSlice(std::min(depth + light.Radius, _far));
+
+	//Project the corners of the box around the light, if any are behind the camera it could cover every tile
+	glm::vec2 ndcMin = glm::vec2(-1.0f);
+	glm::vec2 ndcMax = glm::vec2(1.0f);
+	if (depth - light.Radius > 0.0f)
+	{
+		ndcMin = glm::vec2(FLT_MAX);
+		ndcMax = glm::vec2(-FLT_MAX);
+		for (int i = 0; i < 8; i++)
+		{
+			glm::vec3 corner = viewPos + light.Radius * glm::vec3(i & 1 ? 1.0f : -1.0f, i & 2 ? 1.0f : -1.0f, i & 4 ? 1.0f : -1.0f);
+			glm::vec4 clip = projection * glm::vec4(corner, 1.0f);
+			glm::vec2 ndc = glm::vec2(clip) / clip.w;
+			ndcMin = glm::min(ndcMin, ndc);
+			ndcMax = glm::max(ndcMax, ndc);
+		}
+
+		//Off to the side of the screen
+		if (ndcMax.x < -1.0f || ndcMax.y < -1.0f || ndcMin.x > 1.0f || ndcMin.y > 1.0f)
+			return false;
+	}
+
+	range.MinX = std::clamp(int((ndcMin.x * 0.5f + 0.5f) * TILES_X), 0, TILES_X - 1);
+	range.MaxX = std::clamp(int((ndcMax.x * 0.5f + 0.5f) * TILES_X), 0, TILES_X - 1);
+	range.MinY = std::clamp(int((ndcMin.y * 0.5f + 0.5f) * TILES_Y), 0, TILES_Y - 1);
+	range.MaxY = std::clamp(int((ndcMax.y * 0.5f + 0.5f) * TILES_Y), 0, TILES_Y - 1);
+	return true;
+}
+
+int LightClusters::GetSlice(float depth) const
+{
+	int slice = int(std::log(depth / _near) / std::log(_far / _near) * SLICES);
+	return std::clamp(slice, 0, SLICES - 1);
+}
@@ -0,0 +1,100 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <glad/glad.h>
+#include <Shader.h>
+
+#include "Graphics/PointLight.h"
+#include "Graphics/GLStateCache.h"
+
+//Clustered light culling for forward shading
+//*Splits the view frustum into a grid of clusters (screen tiles x depth slices) and lists the point lights
+//*that reach each one, so a fragment only loops over the handful of lights near it
+class LightClusters
+{
+public:
+	//Grid size, depth slices are spaced exponentially between the near and far planes
+	static const int TILES_X = 16;
+	static const int TILES_Y = 9;
+	static const int SLICES = 24;
+	//Lights past this are ignored
+	static const int MAX_LIGHTS = 1024;
+
+	//Texture slots the cluster buffers get bound to (see frag_phong)
+	static const int LIGHT_SLOT = 20;
+	static const int GRID_SLOT = 21;
+	static const int INDEX_SLOT = 22;
+
+	LightClusters();
+	//Deconstructor
+	//*Deletes the buffers
+	~LightClusters();
+
+	//The clusters own their buffers and textures
+	LightClusters(const LightClusters& other) = delete;
+	LightClusters& operator=(const LightClusters& other) = delete;
+
+	//Creates the texture buffers
+	void Init();
+	//Deletes the texture buffers
+	void Unload();
+
+	//Bins the lights into clusters for this camera and uploads the result
+	//*width and height are the size of the viewport being rendered to
+	void Update(const std::vector<PointLight>& lights, const glm::mat4& view, const glm::mat4& projection, unsigned width, unsigned height);
+
+	//Binds the cluster buffers to their texture slots
+	void Bind() const;
+	void Unbind() const;
+
+	//Sets the uniforms the shaders need to find their cluster
+	void ApplyUniforms(const Shader::sptr& shader) const;
+
+	//Getters
+	//Total light references across every cluster
+	size_t GetIndexCount() const;
+	//Most lights any one cluster has
+	unsigned GetMaxClusterLights() const;
+
+private:
+	struct TextureBuffer
+	{
+		GLuint Buffer = GL_NONE;
+		GLuint Texture = GL_NONE;
+	};
+
+	//Range of clusters a light touches
+	struct ClusterRange
+	{
+		int MinX, MaxX;
+		int MinY, MaxY;
+		int MinZ, MaxZ;
+	};
+
+	//Creates a buffer and a texture viewing it
+	static void CreateBuffer(TextureBuffer& buffer, GLenum format);
+	//Replaces the buffer's contents
+	static void UploadBuffer(const TextureBuffer& buffer, const void* data, size_t bytes);
+
+	//Works out which clusters a light reaches, returns false if it can't be seen
+	bool GetClusterRange(const PointLight& light, const glm::mat4& view, const glm::mat4& projection, ClusterRange& range) const;
+	//Which depth slice a view space depth falls in
+	int GetSlice(float depth) const;
+
+	TextureBuffer _lightBuffer;
+	TextureBuffer _gridBuffer;
+	TextureBuffer _indexBuffer;
+
+	//Position + radius, then colour for each light
+	std::vector<glm::vec4> _lightData;
+	//Offset into _indices and light count for each cluster
+	std::vector<uint32_t> _grid;
+	std::vector<uint32_t> _indices;
+	std::vector<ClusterRange> _ranges;
+
+	float _near = 0.1f;
+	float _far = 100.0f;
+	unsigned _width = 1;
+	unsigned _height = 1;
+	unsigned _maxClusterLights = 0;
+};
@@ -0,0 +1,124 @@
+#include "MeshPool.h"
+
+#include <cstddef>
+#include <Logging.h>
+
+#include "Graphics/GLStateCache.h"
+
+MeshPool::MeshPool()
+{
+}
+
+MeshPool::~MeshPool()
+{
+	Unload();
+}
+
+void MeshPool::Init(size_t maxVertices, size_t maxIndices)
+{
+	Unload();
+
+	_maxVertices = maxVertices;
+	_maxIndices = maxIndices;
+
+	//Only written when a mesh is added, never mapped
+	glCreateBuffers(1, &_vertexBuffer);
+	glNamedBufferStorage(_vertexBuffer, _maxVertices * sizeof(PoolVertex), nullptr, GL_DYNAMIC_STORAGE_BIT);
+	glCreateBuffers(1, &_indexBuffer);
+	glNamedBufferStorage(_indexBuffer, _maxIndices * sizeof(uint32_t), nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+	glCreateVertexArrays(1, &_vao);
+	glVertexArrayVertexBuffer(_vao, 0, _vertexBuffer, 0, sizeof(PoolVertex));
+	glVertexArrayElementBuffer(_vao, _indexBuffer);
+
+	//Position, colour, normal, uv
+	const GLint sizes[4] = { 3, 3, 3, 2 };
+	const GLuint offsets[4] = { offsetof(PoolVertex, Position), offsetof(PoolVertex, Color), offsetof(PoolVertex, Normal), offsetof(PoolVertex, UV) };
+	for (GLuint i = 0; i < 4; i++)
+	{
+		glEnableVertexArrayAttrib(_vao, i);
+		glVertexArrayAttribFormat(_vao, i, sizes[i], GL_FLOAT, GL_FALSE, offsets[i]);
+		glVertexArrayAttribBinding(_vao, i, 0);
+	}
+}
+
+void MeshPool::Unload()
+{
+	if (_vao != GL_NONE)
+	{
+		GLStateCache::ForgetVertexArray(_vao);
+		glDeleteVertexArrays(1, &_vao);
+		glDeleteBuffers(1, &_vertexBuffer);
+		glDeleteBuffers(1, &_indexBuffer);
+		_vao = _vertexBuffer = _indexBuffer = GL_NONE;
+	}
+
+	_vertexCount = _indexCount = 0;
+	_meshes.clear();
+	_vaoToMesh.clear();
+	_pooledVaos.clear();
+}
+
+int MeshPool::AddMesh(const std::vector<PoolVertex>& vertices, const std::vector<uint32_t>& indices, const VertexArrayObject::sptr& vao)
+{
+	return AddMesh(vertices.data(), vertices.size(), indices.data(), indices.size(), vao);
+}
+
+int MeshPool::AddMesh(const PoolVertex* vertices, size_t vertexCount, const uint32_t* indices, size_t indexCount, const VertexArrayObject::sptr& vao)
+{
+	if (_vertexCount + vertexCount > _maxVertices || _indexCount + indexCount > _maxIndices)
+	{
+		LOG_WARN("Mesh pool is full, a mesh with {} vertices will be drawn on its own", vertexCount);
+		return -1;
+	}
+
+	PoolMesh mesh;
+	mesh.FirstIndex = GLuint(_indexCount);
+	mesh.IndexCount = GLuint(indexCount);
+	mesh.BaseVertex = GLint(_vertexCount);
+
+	glNamedBufferSubData(_vertexBuffer, _vertexCount * sizeof(PoolVertex), vertexCount * sizeof(PoolVertex), vertices);
+	glNamedBufferSubData(_indexBuffer, _indexCount * sizeof(uint32_t), indexCount * sizeof(uint32_t), indices);
+	_vertexCount += vertexCount;
+	_indexCount += indexCount;
+
+	int id = int(_meshes.size());
+	_meshes.push_back(mesh);
+	if (vao != nullptr)
+	{
+		_vaoToMesh[vao.get()] = id;
+		_pooledVaos.push_back(vao);
+	}
+	return id;
+}
+
+int MeshPool::Find(const VertexArrayObject::sptr& vao) const
+{
+	auto it = _vaoToMesh.find(vao.get());
+	return it == _vaoToMesh.end() ? -1 : it->second;
+}
+
+const PoolMesh& MeshPool::GetMesh(int id) const
+{
+	return _meshes[id];
+}
+
+size_t MeshPool::GetMeshCount() const
+{
+	return _meshes.size();
+}
+
+GLuint MeshPool::GetVAO() const
+{
+	return _vao;
+}
+
+size_t MeshPool::GetVertexCount() const
+{
+	return _vertexCount;
+}
+
+size_t MeshPool::GetIndexCount() const
+{
+	return _indexCount;
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <glad/glad.h>
+#include <GLM/glm.hpp>
+#include <VertexArrayObject.h>
+
+//Vertex layout of the pool, matches locations 0 - 3 of the scene vertex shaders
+struct PoolVertex
+{
+	glm::vec3 Position;
+	glm::vec3 Color;
+	glm::vec3 Normal;
+	glm::vec2 UV;
+};
+
+//Where a mesh sits in the pool's buffers
+struct PoolMesh
+{
+	GLuint FirstIndex = 0;
+	GLuint IndexCount = 0;
+	GLint BaseVertex = 0;
+};
+
+//Sub-allocates meshes out of one big vertex buffer and one big index buffer that share a single VAO
+//*Everything in the pool can be drawn without switching VAOs, so whole batches go out in one multi draw
+//*Meshes are only ever appended, the pool is sized once up front
+class MeshPool
+{
+public:
+	MeshPool();
+	//Deconstructor
+	//*Deletes the buffers and VAO
+	~MeshPool();
+
+	//A pool owns its buffers
+	MeshPool(const MeshPool& other) = delete;
+	MeshPool& operator=(const MeshPool& other) = delete;
+
+	//Creates buffers big enough for maxVertices and maxIndices in total
+	void Init(size_t maxVertices, size_t maxIndices);
+	//Deletes the buffers and VAO
+	void Unload();
+
+	//Copies a mesh into the pool and returns its id, or -1 if it doesn't fit
+	//*vao is the standalone copy of the same mesh, so renderers using it can be found in the pool (see Find)
+	int AddMesh(const std::vector<PoolVertex>& vertices, const std::vector<uint32_t>& indices, const VertexArrayObject::sptr& vao = nullptr);
+	//Same as above, for data that isn't in vectors (like a mapped compiled mesh)
+	int AddMesh(const PoolVertex* vertices, size_t vertexCount, const uint32_t* indices, size_t indexCount, const VertexArrayObject::sptr& vao = nullptr);
+	//Id of the pooled copy of a VAO, -1 if it isn't pooled
+	int Find(const VertexArrayObject::sptr& vao) const;
+
+	//Getters
+	const PoolMesh& GetMesh(int id) const;
+	size_t GetMeshCount() const;
+	GLuint GetVAO() const;
+	size_t GetVertexCount() const;
+	size_t GetIndexCount() const;
+
+private:
+	GLuint _vao = GL_NONE;
+	GLuint _vertexBuffer = GL_NONE;
+	GLuint _indexBuffer = GL_NONE;
+
+	size_t _maxVertices = 0;
+	size_t _maxIndices = 0;
+	//Next free vertex and index
+	size_t _vertexCount = 0;
+	size_t _indexCount = 0;
+
+	std::vector<PoolMesh> _meshes;
+	std::unordered_map<const VertexArrayObject*, int> _vaoToMesh;
+	//Keeps the VAOs in _vaoToMesh alive, so a new VAO can't reuse the address of a pooled one
+	std::vector<VertexArrayObject::sptr> _pooledVaos;
+};
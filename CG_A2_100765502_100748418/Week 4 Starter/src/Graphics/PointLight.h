@@ -0,0 +1,12 @@
+#pragma once
+#include <GLM/glm.hpp>
+
+//A light that shines in every direction from a point and fades out by Radius
+struct PointLight
+{
+	glm::vec3 Position = glm::vec3(0.0f);
+	//Distance at which the light has faded to nothing
+	float Radius = 5.0f;
+	glm::vec3 Color = glm::vec3(1.0f);
+	float Intensity = 1.0f;
+};
@@ -0,0 +1,129 @@
+#include "ColorGradingStage.h"
+
+#include <algorithm>
+
+void ColorGradingStage::Init(unsigned width, unsigned height)
+{
+	//Set up shaders
+	_shaders.push_back(ShaderLibrary::Load("shaders/passthrough_vert.glsl", "shaders/Post/color_correction_frag.glsl"));
+}
+
+void ColorGradingStage::Update(float deltaTime)
+{
+	if (!IsFading())
+		return;
+
+	_fadeTime = std::min(_fadeTime + deltaTime, _fadeDuration);
+	float t = _fadeTime / _fadeDuration;
+
+	//Everything fades towards zero except the target which fades towards one
+	for (unsigned i = 0; i < _weights.size(); i++)
+	{
+		float to = int(i) == _targetGrade ? 1.0f : 0.0f;
+		_weights[i] = _fadeFrom[i] + (to - _fadeFrom[i]) * t;
+	}
+}
+
+int ColorGradingStage::AddGrade(LUT3D* lut)
+{
+	_grades.push_back(lut);
+	//The first grade shows until we're told otherwise
+	_weights.push_back(_grades.size() == 1 ? 1.0f : 0.0f);
+	_fadeFrom.push_back(0.0f);
+
+	return int(_grades.size()) - 1;
+}
+
+void ColorGradingStage::SetGrade(int index)
+{
+	for (unsigned i = 0; i < _weights.size(); i++)
+	{
+		_weights[i] = int(i) == index ? 1.0f : 0.0f;
+	}
+
+	_targetGrade = index;
+	_fadeDuration = 0.0f;
+	_fadeTime = 0.0f;
+}
+
+void ColorGradingStage::CrossFadeTo(int index, float duration)
+{
+	if (duration <= 0.0f)
+	{
+		SetGrade(index);
+		return;
+	}
+
+	//Fade from wherever we are now, even if that's halfway through another fade
+	_fadeFrom = _weights;
+	_targetGrade = index;
+	_fadeDuration = duration;
+	_fadeTime = 0.0f;
+}
+
+int ColorGradingStage::GetTargetGrade() const
+{
+	return _targetGrade;
+}
+
+bool ColorGradingStage::IsFading() const
+{
+	return _fadeTime < _fadeDuration;
+}
+
+void ColorGradingStage::ApplyUniforms(const Shader::sptr& shader)
+{
+	//Pick the heaviest grades, quick switching can leave more than we can bind at once
+	//*A LUT that failed to load has no size, the shader would divide by it, so it's left out and the rest renormalized
+	std::vector<int> order;
+	for (unsigned i = 0; i < _weights.size(); i++)
+	{
+		if (_weights[i] > 0.0f && _grades[i] != nullptr && _grades[i]->getSize() > 0)
+			order.push_back(int(i));
+	}
+	std::sort(order.begin(), order.end(), [&](int l, int r) { return _weights[l] > _weights[r]; });
+	_boundCount = std::min(int(order.size()), MAX_BLENDED);
+
+	float total = 0.0f;
+	for (int i = 0; i < _boundCount; i++)
+		total += _weights[order[i]];
+
+	glm::vec4 weights = glm::vec4(0.0f);
+	glm::vec4 sizes = glm::vec4(64.0f);
+	for (int i = 0; i < _boundCount; i++)
+	{
+		LUT3D* lut = _grades[order[i]];
+		lut->bind(FIRST_LUT_SLOT + i);
+
+		//Renormalize in case some small weights or invalid LUTs got dropped
+		weights[i] = _weights[order[i]] / total;
+		sizes[i] = float(lut->getSize());
+
+		static const char* domainMinNames[MAX_BLENDED] = { "u_DomainMin[0]", "u_DomainMin[1]", "u_DomainMin[2]", "u_DomainMin[3]" };
+		static const char* domainMaxNames[MAX_BLENDED] = { "u_DomainMax[0]", "u_DomainMax[1]", "u_DomainMax[2]", "u_DomainMax[3]" };
+		shader->SetUniform(domainMinNames[i], lut->getDomainMin());
+		shader->SetUniform(domainMaxNames[i], lut->getDomainMax());
+	}
+
+	shader->SetUniform("u_LutCount", _boundCount);
+	shader->SetUniform("u_LutWeights", weights);
+	shader->SetUniform("u_LutSizes", sizes);
+}
+
+void ColorGradingStage::UnbindResources()
+{
+	for (int i = 0; i < _boundCount; i++)
+	{
+		GLStateCache::BindTexture(FIRST_LUT_SLOT + i, GL_NONE);
+	}
+}
+
+const char* ColorGradingStage::GetFusionSource() const
+{
+	return "shaders/Post/color_correction_frag.glsl";
+}
+
+const char* ColorGradingStage::GetFusionFunction() const
+{
+	return "ColorCorrect";
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "Graphics/Post/PostEffect.h"
+#include "Graphics/LUT.h"
+
+//Colour grades using a weighted blend of several LUTs
+//*Switching grades only changes weights, the LUTs stay uploaded and are never copied
+class ColorGradingStage : public PostEffect
+{
+public:
+	//Most LUTs that get blended in one pass
+	static const int MAX_BLENDED = 4;
+	//Texture slot the first LUT goes in, the rest follow on
+	static const int FIRST_LUT_SLOT = 30;
+
+	//Loads the shader
+	void Init(unsigned width, unsigned height) override;
+
+	//Binds the heaviest grades and sets their weights
+	void ApplyUniforms(const Shader::sptr& shader) override;
+	//Unbinds the grades
+	void UnbindResources() override;
+
+	//Can be fused, it only changes each pixel's colour
+	const char* GetFusionSource() const override;
+	const char* GetFusionFunction() const override;
+
+	//Advances any cross-fade
+	void Update(float deltaTime);
+
+	//Adds a grade and returns its index, the stage doesn't own the LUT
+	int AddGrade(LUT3D* lut);
+	//Switches to a grade straight away
+	void SetGrade(int index);
+	//Fades from whatever is showing to a grade over some seconds
+	void CrossFadeTo(int index, float duration);
+
+	//Getters
+	int GetTargetGrade() const;
+	bool IsFading() const;
+
+private:
+	//Every grade we can blend between
+	std::vector<LUT3D*> _grades;
+	//How much each grade contributes
+	std::vector<float> _weights;
+	//Weights when the current fade started
+	std::vector<float> _fadeFrom;
+
+	int _targetGrade = 0;
+	float _fadeTime = 0.0f;
+	float _fadeDuration = 0.0f;
+
+	//Grades bound for this pass
+	int _boundCount = 0;
+};
@@ -2,48 +2,24 @@
 
 void GreyscaleEffect::Init(unsigned width, unsigned height)
 {
-	int index = int(_buffers.size());
-	_buffers.push_back(new Framebuffer());
-	_buffers[index]->AddColorTarget(GL_RGBA8);
-	_buffers[index]->AddDepthTarget();
-	_buffers[index]->Init(width, height);
-
 	//Loads the shaders
-	index = int(_shaders.size());
-	_shaders.push_back(Shader::Create());
-	_shaders[index]->LoadShaderPartFromFile("shaders/passthrough_vert.glsl", GL_VERTEX_SHADER);
-	_shaders[index]->LoadShaderPartFromFile("shaders/Post/greyscale_frag.glsl", GL_FRAGMENT_SHADER);
-	_shaders[index]->Link();
+	_shaders.push_back(ShaderLibrary::Load("shaders/passthrough_vert.glsl", "shaders/Post/greyscale_frag.glsl"));
 }
 
-void GreyscaleEffect::ApplyEffect(PostEffect* buffer)
+void GreyscaleEffect::ApplyUniforms(const Shader::sptr& shader)
 {
-	BindShader(0);
-
-	_shaders[0]->SetUniform("u_Intensity", _intensity);
-
-	buffer->BindColorAsTexture(0, 0, 0);
-
-	_buffers[0]->RenderToFSQ();
-
-	buffer->UnbindTexture(0);
+	shader->SetUniform("u_GreyscaleIntensity", _intensity);
+}
 
-	UnbindShader();
+const char* GreyscaleEffect::GetFusionSource() const
+{
+	return "shaders/Post/greyscale_frag.glsl";
 }
 
-//void GreyscaleEffect::DrawToScreen()
-//{
-//	BindShader(0);
-//	_shaders[0]->SetUniform("U_Intensity", _intensity);
-//
-//	BindColorAsTexture(0, 0, 0);
-//
-//	_buffers[0]->DrawFullscreenQuad();
-//
-//	UnbindTexture(0);
-//
-//	UnbindShader();
-//}
+const char* GreyscaleEffect::GetFusionFunction() const
+{
+	return "Greyscale";
+}
 
 float GreyscaleEffect::GetIntensity() const
 {
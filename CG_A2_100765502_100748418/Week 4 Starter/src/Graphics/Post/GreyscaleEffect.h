@@ -5,24 +5,24 @@
 class GreyscaleEffect : public PostEffect
 {
 public:
-	//Initializes framebuffer
+	//Loads the shader
 	//Ovverides post effect Init
 	void Init(unsigned width, unsigned height) override;
 
-	//Applies the effect to this buffer
-	//passes the previous framebuffer with the texture to apply as parameter
-	void ApplyEffect(PostEffect* buffer) override;
-
-	////Applies the effect to the screen
-	//void DrawToScreen() override;
-
 	//Getters
 	float GetIntensity() const;
 
 	//Setters
 	void SetIntensity(float intensity);
 
+	//Sets the intensity before the pass draws
+	void ApplyUniforms(const Shader::sptr& shader) override;
+
+	//Can be fused, it only changes each pixel's colour
+	const char* GetFusionSource() const override;
+	const char* GetFusionFunction() const override;
+
 private:
 	float _intensity = 1.0f;
 
-};
\ No newline at end of file
+};
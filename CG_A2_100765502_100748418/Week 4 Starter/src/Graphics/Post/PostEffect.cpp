@@ -2,48 +2,55 @@
 
 void PostEffect::Init(unsigned width, unsigned height)
 {
-	if (!_shaders.size() > 0)
-	{
-
-		int index = int(_buffers.size());
-		_buffers.push_back(new Framebuffer());
-		_buffers[index]->AddColorTarget(GL_RGBA8);
-		_buffers[index]->AddDepthTarget();
-		_buffers[index]->Init(width, height);
-	}
-
-	_shaders.push_back(Shader::Create());
-	_shaders[_shaders.size() - 1]->LoadShaderPartFromFile("shaders/passthrough_vert.glsl", GL_VERTEX_SHADER);
-	_shaders[_shaders.size() - 1]->LoadShaderPartFromFile("shaders/passthrough_frag.glsl", GL_FRAGMENT_SHADER);
-	_shaders[_shaders.size() - 1]->Link();
-
+	_shaders.push_back(ShaderLibrary::Load("shaders/passthrough_vert.glsl", "shaders/passthrough_frag.glsl"));
 }
 
-void PostEffect::ApplyEffect(PostEffect* previousBuffer)
+void PostEffect::Render(Framebuffer* input, Framebuffer* output)
 {
-	BindShader(_shaders.size() - 1);
+	BindShader(0);
 
-	previousBuffer->BindColorAsTexture(0, 0, 0);
+	//Only part of the input texture may have been rendered to
+	_shaders[0]->SetUniform("u_UVScale", input->GetUVScale());
+	ApplyUniforms(_shaders[0]);
 
-	_buffers[0]->RenderToFSQ();
+	input->BindColorAsTexture(0, 0);
 
-	previousBuffer->UnbindTexture(0);
+	DrawPass(output);
 
+	input->UnbindTexture(0);
 
+	UnbindResources();
 	UnbindShader();
 }
 
-void PostEffect::DrawToScreen()
+void PostEffect::ApplyUniforms(const Shader::sptr& shader)
 {
-	BindShader(_shaders.size() - 1);
+}
 
-	BindColorAsTexture(0, 0, 0);
+void PostEffect::UnbindResources()
+{
+}
 
-	_buffers[0]->DrawFullscreenQuad();
+const char* PostEffect::GetFusionSource() const
+{
+	return nullptr;
+}
 
-	UnbindTexture(0);
+const char* PostEffect::GetFusionFunction() const
+{
+	return nullptr;
+}
 
-	UnbindShader();
+void PostEffect::DrawPass(Framebuffer* output)
+{
+	if (output != nullptr)
+	{
+		output->RenderToFSQ();
+	}
+	else
+	{
+		Framebuffer::DrawFullscreenQuad();
+	}
 }
 
 void PostEffect::Reshape(unsigned width, unsigned height)
@@ -54,6 +61,14 @@ void PostEffect::Reshape(unsigned width, unsigned height)
 	}
 }
 
+void PostEffect::ApplyPendingResize()
+{
+	for (unsigned int i = 0; i < _buffers.size(); i++)
+	{
+		_buffers[i]->ApplyPendingResize();
+	}
+}
+
 void PostEffect::Clear()
 {
 	for (unsigned int i = 0; i < _buffers.size(); i++)
@@ -84,7 +99,7 @@ void PostEffect::BindBuffer(int index)
 
 void PostEffect::UnbindBuffer()
 {
-	glBindFramebuffer(GL_FRAMEBUFFER, GL_NONE);
+	GLStateCache::BindFramebuffer(GL_FRAMEBUFFER, GL_NONE);
 }
 
 void PostEffect::BindColorAsTexture(int index, int colorBuffer, int textureSlot)
@@ -99,16 +114,15 @@ void PostEffect::BindDepthAsTexture(int index, int textureSlot)
 
 void PostEffect::UnbindTexture(int textureSlot)
 {
-	glActiveTexture(GL_TEXTURE0 + textureSlot);
-	glBindTexture(GL_TEXTURE_2D, GL_NONE);
+	GLStateCache::BindTexture(textureSlot, GL_NONE);
 }
 
 void PostEffect::BindShader(int index)
 {
-	_shaders[index]->Bind();
+	GLStateCache::UseProgram(_shaders[index]);
 }
 
 void PostEffect::UnbindShader()
 {
-	glUseProgram(GL_NONE);
+	GLStateCache::UseProgram(GL_NONE);
 }
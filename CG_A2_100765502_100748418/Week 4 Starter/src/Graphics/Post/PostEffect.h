@@ -2,6 +2,7 @@
 
 #include "Graphics/Framebuffer.h"
 #include "Shader.h"
+#include "Graphics/ShaderLibrary.h"
 
 class PostEffect
 {
@@ -9,12 +10,26 @@ public:
 	//Initialize this effects (will be overriden in each derived class0
 	virtual void Init(unsigned width, unsigned height);
 
-	//Applies the effect
-	virtual void ApplyEffect(PostEffect* previousBuffer);
-	virtual void DrawToScreen();
+	//Renders the effect reading the colour of input and writing to output
+	//*output being nullptr means the currently bound framebuffer (the back buffer)
+	virtual void Render(Framebuffer* input, Framebuffer* output);
+
+	//Sets this effect's uniforms (and binds its textures) on shader before a pass draws
+	//*shader is either this effect's own shader or a fused one
+	virtual void ApplyUniforms(const Shader::sptr& shader);
+	//Unbinds anything ApplyUniforms bound
+	virtual void UnbindResources();
+
+	//Effects that only change each pixel's colour can be fused into one pass with their neighbours
+	//*Returns the shader file with the effect's function in it, or nullptr if it can't be fused
+	virtual const char* GetFusionSource() const;
+	//Name of the vec4 -> vec4 function in that file
+	virtual const char* GetFusionFunction() const;
 
 	//Reshapes the buffer
 	virtual void Reshape(unsigned width, unsigned height);
+	//Reallocates buffers once a resize has settled
+	void ApplyPendingResize();
 
 	//Clears the buffers
 	void Clear();
@@ -35,11 +50,16 @@ public:
 	void BindShader(int index);
 	void UnbindShader();
 
+	//Draws the fullscreen quad into output (or the bound framebuffer)
+	static void DrawPass(Framebuffer* output);
+
 protected:
-	//Holds all our buffers for the effects
+
+	//Any buffers an effect needs for itself (intermediate steps)
+	//*The input and output of the effect come from the PostProcessGraph
 	std::vector<Framebuffer*> _buffers;
 
 	std::vector<Shader::sptr> _shaders;
 
 
-};
\ No newline at end of file
+};
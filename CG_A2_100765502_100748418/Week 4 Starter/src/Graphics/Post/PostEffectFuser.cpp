@@ -0,0 +1,87 @@
+#include "PostEffectFuser.h"
+
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+
+Shader::sptr PostEffectFuser::GetProgram(const std::vector<PostEffect*>& effects)
+{
+	//The permutation key is just the functions in order
+	std::string key;
+	for (unsigned i = 0; i < effects.size(); i++)
+	{
+		key += effects[i]->GetFusionFunction();
+		key += '|';
+	}
+
+	auto found = _programs.find(key);
+	if (found != _programs.end())
+		return found->second;
+
+	//Shared inputs, then each effect's function, then a main calling them in order
+	std::string source =
+		"#version 420\n"
+		"#define FUSED_POST\n"
+		"layout(location = 0) in vec2 inUV;\n"
+		"out vec4 frag_color;\n"
+		"layout (binding = 0) uniform sampler2D s_screenTex;\n";
+
+	std::vector<std::string> included;
+	for (unsigned i = 0; i < effects.size(); i++)
+	{
+		//The same effect twice only needs its function once
+		std::string path = effects[i]->GetFusionSource();
+		if (std::find(included.begin(), included.end(), path) != included.end())
+			continue;
+
+		included.push_back(path);
+		source += "#line 1\n";
+		source += GetSnippet(path.c_str());
+		source += "\n";
+	}
+
+	source += "void main()\n{\n\tvec4 color = texture(s_screenTex, inUV);\n";
+	for (unsigned i = 0; i < effects.size(); i++)
+	{
+		source += "\tcolor = ";
+		source += effects[i]->GetFusionFunction();
+		source += "(color);\n";
+	}
+	source += "\tfrag_color = color;\n}\n";
+
+	Shader::sptr program = ShaderLibrary::LoadWithFragmentSource("shaders/passthrough_vert.glsl", source);
+
+	_programs[key] = program;
+	return program;
+}
+
+size_t PostEffectFuser::GetProgramCount() const
+{
+	return _programs.size();
+}
+
+void PostEffectFuser::Clear()
+{
+	_programs.clear();
+}
+
+const std::string& PostEffectFuser::GetSnippet(const char* path)
+{
+	auto found = _snippets.find(path);
+	if (found != _snippets.end())
+		return found->second;
+
+	std::ifstream file(path);
+	std::stringstream contents;
+	contents << file.rdbuf();
+
+	//Drop the #version line, the fused shader has its own
+	std::string snippet = contents.str();
+	if (snippet.compare(0, 8, "#version") == 0)
+	{
+		size_t lineEnd = snippet.find('\n');
+		snippet.erase(0, lineEnd == std::string::npos ? snippet.size() : lineEnd + 1);
+	}
+
+	return _snippets[path] = snippet;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <unordered_map>
+#include <string>
+
+#include "Graphics/Post/PostEffect.h"
+
+//Builds one fragment shader that runs several per-pixel effects back to back
+//*Each effect's shader file provides a vec4 -> vec4 function, the fused main calls them in order
+//*Programs are cached by the ordered list of functions, so each combination is only linked once
+class PostEffectFuser
+{
+public:
+	//Gets the fused program for these effects (in this order)
+	//*Every effect must be fusable (GetFusionSource isn't nullptr)
+	Shader::sptr GetProgram(const std::vector<PostEffect*>& effects);
+
+	//How many different combinations have been linked
+	size_t GetProgramCount() const;
+
+	//Drops every cached program
+	void Clear();
+
+private:
+	//Reads a snippet file once, minus its #version line
+	const std::string& GetSnippet(const char* path);
+
+	//Linked programs keyed by their function names joined together
+	std::unordered_map<std::string, Shader::sptr> _programs;
+	//Snippet sources keyed by path
+	std::unordered_map<std::string, std::string> _snippets;
+};
@@ -0,0 +1,156 @@
+#include "PostProcessGraph.h"
+
+void PostProcessGraph::Init(unsigned width, unsigned height)
+{
+	_width = width;
+	_height = height;
+}
+
+int PostProcessGraph::AddPass(PostEffect* effect, bool enabled)
+{
+	_passes.push_back({ effect, enabled });
+	return int(_passes.size()) - 1;
+}
+
+void PostProcessGraph::SetEnabled(int pass, bool enabled)
+{
+	_passes[pass].Enabled = enabled;
+}
+
+bool PostProcessGraph::IsEnabled(int pass) const
+{
+	return _passes[pass].Enabled;
+}
+
+void PostProcessGraph::SetFusion(bool fuse)
+{
+	_fuse = fuse;
+}
+
+bool PostProcessGraph::IsFusing() const
+{
+	return _fuse;
+}
+
+void PostProcessGraph::Execute(Framebuffer* source, Framebuffer* output)
+{
+	//Group the enabled passes into the fullscreen passes we'll actually draw
+	//*With fusion on, a run of per-pixel effects becomes one group
+	std::vector<std::vector<PostEffect*>> groups;
+	bool lastFusable = false;
+	for (unsigned i = 0; i < _passes.size(); i++)
+	{
+		if (!_passes[i].Enabled)
+			continue;
+
+		PostEffect* effect = _passes[i].Effect;
+		bool fusable = _fuse && effect->GetFusionSource() != nullptr;
+		if (groups.empty() || !fusable || !lastFusable)
+			groups.push_back(std::vector<PostEffect*>());
+
+		groups.back().push_back(effect);
+		lastFusable = fusable;
+	}
+
+	_lastPassCount = int(groups.size());
+
+	//Nothing to do, just copy the source over
+	if (groups.empty())
+	{
+		if (output == nullptr)
+			source->DrawToBackbuffer();
+		else
+			source->DrawToFramebuffer(*output);
+		return;
+	}
+
+	Framebuffer* input = source;
+	for (unsigned i = 0; i < groups.size(); i++)
+	{
+		//Fullscreen passes write every pixel, so targets never need clearing
+		//*Targets match what the source actually renders, so a pending resize never creates or grows one
+		Framebuffer* target = i == groups.size() - 1 ? output : _pool.Acquire(_format, source->GetRenderWidth(), source->GetRenderHeight());
+
+		//Intermediate passes set their own viewport, the back buffer covers the whole window
+		if (target == nullptr)
+			GLStateCache::Viewport(0, 0, _width, _height);
+
+		if (groups[i].size() == 1)
+			groups[i][0]->Render(input, target);
+		else
+			RenderFused(groups[i], input, target);
+
+		//The input has been read, it can be used for the next pass's output
+		if (input != source)
+			_pool.Release(input);
+		input = target;
+	}
+}
+
+void PostProcessGraph::RenderFused(const std::vector<PostEffect*>& effects, Framebuffer* input, Framebuffer* output)
+{
+	Shader::sptr program = _fuser.GetProgram(effects);
+	GLStateCache::UseProgram(program);
+	//Only part of the input texture may have been rendered to
+	program->SetUniform("u_UVScale", input->GetUVScale());
+
+	for (unsigned i = 0; i < effects.size(); i++)
+	{
+		effects[i]->ApplyUniforms(program);
+	}
+
+	input->BindColorAsTexture(0, 0);
+
+	PostEffect::DrawPass(output);
+
+	input->UnbindTexture(0);
+
+	for (unsigned i = 0; i < effects.size(); i++)
+	{
+		effects[i]->UnbindResources();
+	}
+
+	GLStateCache::UseProgram(GL_NONE);
+}
+
+void PostProcessGraph::Reshape(unsigned width, unsigned height)
+{
+	_width = width;
+	_height = height;
+	_pool.Reshape(width, height);
+}
+
+void PostProcessGraph::ApplyPendingResize()
+{
+	_pool.ApplyPendingResize();
+}
+
+void PostProcessGraph::Unload()
+{
+	_pool.Unload();
+}
+
+size_t PostProcessGraph::GetPassCount() const
+{
+	return _passes.size();
+}
+
+PostEffect* PostProcessGraph::GetEffect(int pass) const
+{
+	return _passes[pass].Effect;
+}
+
+size_t PostProcessGraph::GetTargetCount() const
+{
+	return _pool.GetTargetCount();
+}
+
+int PostProcessGraph::GetLastPassCount() const
+{
+	return _lastPassCount;
+}
+
+const PostEffectFuser& PostProcessGraph::GetFuser() const
+{
+	return _fuser;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "Graphics/Post/PostEffect.h"
+#include "Graphics/Post/PostEffectFuser.h"
+#include "Graphics/RenderTargetPool.h"
+
+//Runs a chain of post effects
+//*Each pass reads the previous pass's output and writes a target borrowed from a shared pool,
+//*so however many effects there are only two targets ever get created (ping-pong)
+//*Disabled passes are skipped completely, nothing is cleared or drawn for them
+//*With fusion on, neighbouring per-pixel passes are merged into a single fullscreen pass
+class PostProcessGraph
+{
+public:
+	//Initializes the graph for the screen size
+	void Init(unsigned width, unsigned height);
+
+	//Adds an effect to the end of the chain and returns its pass index
+	int AddPass(PostEffect* effect, bool enabled = true);
+
+	//Turns a pass on or off
+	void SetEnabled(int pass, bool enabled);
+	bool IsEnabled(int pass) const;
+
+	//Turns merging of neighbouring per-pixel passes on or off
+	void SetFusion(bool fuse);
+	bool IsFusing() const;
+
+	//Runs every enabled pass over the colour of source
+	//*The last pass draws to output, or the back buffer when output is nullptr
+	void Execute(Framebuffer* source, Framebuffer* output = nullptr);
+
+	//Resizes the pooled targets
+	void Reshape(unsigned width, unsigned height);
+	//Reallocates pooled targets once a resize has settled
+	void ApplyPendingResize();
+
+	//Deletes the pooled targets
+	void Unload();
+
+	//Getters
+	size_t GetPassCount() const;
+	PostEffect* GetEffect(int pass) const;
+	size_t GetTargetCount() const;
+	//How many fullscreen passes the last Execute drew
+	int GetLastPassCount() const;
+	const PostEffectFuser& GetFuser() const;
+
+private:
+	//Draws a run of fusable effects as one pass
+	void RenderFused(const std::vector<PostEffect*>& effects, Framebuffer* input, Framebuffer* output);
+
+	struct PostPass
+	{
+		//Reads its input from slot 0 and writes to its output
+		PostEffect* Effect;
+		bool Enabled;
+	};
+
+	std::vector<PostPass> _passes;
+	RenderTargetPool _pool;
+	PostEffectFuser _fuser;
+
+	bool _fuse = true;
+	int _lastPassCount = 0;
+
+	//Format of the intermediate targets
+	GLenum _format = GL_RGBA8;
+
+	unsigned _width = 0;
+	unsigned _height = 0;
+};
@@ -2,34 +2,23 @@
 
 void SepiaEffect::Init(unsigned width, unsigned height)
 {
-	int index = int(_buffers.size());
-	_buffers.push_back(new Framebuffer());
-	_buffers[index]->AddColorTarget(GL_RGBA8);
-	_buffers[index]->AddDepthTarget();
-	_buffers[index]->Init(width, height);
-
 	//Set up shaders
-	index = int(_shaders.size());
-	_shaders.push_back(Shader::Create());
-	_shaders[index]->LoadShaderPartFromFile("shaders/passthrough_vert.glsl", GL_VERTEX_SHADER);
-	_shaders[index]->LoadShaderPartFromFile("shaders/Post/sepia_frag.glsl", GL_FRAGMENT_SHADER);
-	_shaders[index]->Link();
-
-	PostEffect::Init(width, height);
+	_shaders.push_back(ShaderLibrary::Load("shaders/passthrough_vert.glsl", "shaders/Post/sepia_frag.glsl"));
 }
 
-void SepiaEffect::ApplyEffect(PostEffect* buffer)
+void SepiaEffect::ApplyUniforms(const Shader::sptr& shader)
 {
-	BindShader(0);
-	_shaders[0]->SetUniform("u_Intensity", _intensity);
-
-	buffer->BindColorAsTexture(0, 0, 0);
-
-	_buffers[0]->RenderToFSQ();
+	shader->SetUniform("u_SepiaIntensity", _intensity);
+}
 
-	buffer->UnbindTexture(0);
+const char* SepiaEffect::GetFusionSource() const
+{
+	return "shaders/Post/sepia_frag.glsl";
+}
 
-	UnbindShader();
+const char* SepiaEffect::GetFusionFunction() const
+{
+	return "Sepia";
 }
 
 float SepiaEffect::GetIntensity() const
@@ -5,18 +5,22 @@
 class SepiaEffect : public PostEffect
 {
 public:
-	//Initializes framebuffer
+	//Loads the shader
 	void Init(unsigned width, unsigned height) override;
 
-	//Applies effect to this buffer
-	void ApplyEffect(PostEffect* buffer) override;
-
 	//Getters
 	float GetIntensity() const;
 
 	//Setters
 	void SetIntensity(float intensity);
 
+	//Sets the intensity before the pass draws
+	void ApplyUniforms(const Shader::sptr& shader) override;
+
+	//Can be fused, it only changes each pixel's colour
+	const char* GetFusionSource() const override;
+	const char* GetFusionFunction() const override;
+
 private:
 	float _intensity = 0.7f;
-};
\ No newline at end of file
+};
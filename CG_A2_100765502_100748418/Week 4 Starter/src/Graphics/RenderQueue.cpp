@@ -0,0 +1,155 @@
+#include "RenderQueue.h"
+
+#include <algorithm>
+#include <Transform.h>
+
+RenderQueue::RenderQueue(entt::registry& registry)
+	: _registry(registry)
+{
+	_registry.on_construct<RendererComponent>().connect<&RenderQueue::OnChanged>(*this);
+	_registry.on_update<RendererComponent>().connect<&RenderQueue::OnChanged>(*this);
+	_registry.on_destroy<RendererComponent>().connect<&RenderQueue::OnChanged>(*this);
+}
+
+RenderQueue::~RenderQueue()
+{
+	_registry.on_construct<RendererComponent>().disconnect<&RenderQueue::OnChanged>(*this);
+	_registry.on_update<RendererComponent>().disconnect<&RenderQueue::OnChanged>(*this);
+	_registry.on_destroy<RendererComponent>().disconnect<&RenderQueue::OnChanged>(*this);
+}
+
+void RenderQueue::MarkDirty()
+{
+	_dirty = true;
+}
+
+void RenderQueue::SetDepthSorting(bool enabled, float maxDepth)
+{
+	if (_depthSorting != enabled)
+		_dirty = true;
+	_depthSorting = enabled;
+	_maxDepth = maxDepth;
+}
+
+const std::vector<RenderItem>& RenderQueue::Update(const glm::vec3& cameraPosition)
+{
+	//SetMaterial doesn't go through the registry, so check the materials haven't been swapped out
+	if (!_dirty)
+	{
+		for (const RenderItem& item : _items)
+		{
+			if (_registry.get<RendererComponent>(item.Entity).Material.get() != item.Material)
+			{
+				_dirty = true;
+				break;
+			}
+		}
+	}
+
+	if (_dirty || _depthSorting)
+	{
+		BuildKeys(cameraPosition);
+		RadixSort();
+		_sortCount++;
+		_dirty = false;
+	}
+
+	return _items;
+}
+
+uint64_t RenderQueue::MakeKey(int renderLayer, uint16_t shaderId, uint16_t materialId, float depth)
+{
+	//Layers can be negative, shift them so they still sort in order
+	uint64_t layer = uint64_t(std::clamp(renderLayer + 128, 0, 255));
+	uint64_t depthBits = uint64_t(std::clamp(depth, 0.0f, 1.0f) * float((1 << 24) - 1));
+
+	return (layer << 56) | (uint64_t(shaderId) << 40) | (uint64_t(materialId) << 24) | depthBits;
+}
+
+const std::vector<RenderItem>& RenderQueue::GetItems() const
+{
+	return _items;
+}
+
+bool RenderQueue::IsDepthSorting() const
+{
+	return _depthSorting;
+}
+
+size_t RenderQueue::GetSortCount() const
+{
+	return _sortCount;
+}
+
+void RenderQueue::OnChanged(entt::registry& registry, entt::entity entity)
+{
+	_dirty = true;
+}
+
+void RenderQueue::BuildKeys(const glm::vec3& cameraPosition)
+{
+	_items.clear();
+	_registry.view<RendererComponent>().each([&](entt::entity entity, RendererComponent& renderer) {
+		if (renderer.Material == nullptr)
+			return;
+
+		float depth = 0.0f;
+		if (_depthSorting)
+		{
+			if (Transform* transform = _registry.try_get<Transform>(entity))
+				depth = glm::length(glm::vec3(transform->WorldTransform()[3]) - cameraPosition) / _maxDepth;
+		}
+
+		uint16_t shaderId = GetId(_shaderIds, renderer.Material->Shader.get());
+		uint16_t materialId = GetId(_materialIds, renderer.Material.get());
+		_items.push_back({ MakeKey(renderer.Material->RenderLayer, shaderId, materialId, depth), entity, renderer.Material.get() });
+	});
+}
+
+void RenderQueue::RadixSort()
+{
+	size_t count = _items.size();
+	if (count < 2)
+		return;
+
+	//Count every digit in one go
+	size_t histograms[8][256] = {};
+	for (const RenderItem& item : _items)
+	{
+		for (int digit = 0; digit < 8; digit++)
+			histograms[digit][(item.Key >> (digit * 8)) & 0xFF]++;
+	}
+
+	_sortBuffer.resize(count);
+	for (int digit = 0; digit < 8; digit++)
+	{
+		size_t* histogram = histograms[digit];
+		//Every key has the same byte here (depth bits with depth sorting off, or one layer), nothing would move
+		if (histogram[(_items[0].Key >> (digit * 8)) & 0xFF] == count)
+			continue;
+
+		size_t offset = 0;
+		for (int bucket = 0; bucket < 256; bucket++)
+		{
+			size_t bucketCount = histogram[bucket];
+			histogram[bucket] = offset;
+			offset += bucketCount;
+		}
+
+		for (const RenderItem& item : _items)
+			_sortBuffer[histogram[(item.Key >> (digit * 8)) & 0xFF]++] = item;
+		_items.swap(_sortBuffer);
+	}
+}
+
+uint16_t RenderQueue::GetId(std::unordered_map<const void*, uint16_t>& ids, const void* pointer)
+{
+	auto it = ids.find(pointer);
+	if (it != ids.end())
+		return it->second;
+
+	//Ids wrap past 65535, things still draw, they just might not group as well
+	uint16_t id = uint16_t(ids.size());
+	ids.emplace(pointer, id);
+	return id;
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <Scene.h>
+#include <RendererComponent.h>
+
+//One renderer in the queue
+struct RenderItem
+{
+	//Layer, shader, material then depth, see RenderQueue::MakeKey
+	uint64_t Key;
+	entt::entity Entity;
+	//Material the key was made from, if the renderer's material changes the key is stale
+	const ShaderMaterial* Material;
+};
+
+//Keeps every RendererComponent sorted by a 64 bit key so draws with the same state end up together
+//*Keys are packed once and radix sorted, and only when renderers are added, removed or change material
+//*Bits from the top: render layer (8), shader (16), material (16), depth (24)
+class RenderQueue
+{
+public:
+	explicit RenderQueue(entt::registry& registry);
+	//Stops listening to the registry
+	~RenderQueue();
+
+	RenderQueue(const RenderQueue& other) = delete;
+	RenderQueue& operator=(const RenderQueue& other) = delete;
+
+	//Forces the keys to be rebuilt next update
+	void MarkDirty();
+	//Sorts front to back within a material (for heavy fragment shaders), this re-sorts every frame since the camera moves
+	void SetDepthSorting(bool enabled, float maxDepth = 1000.0f);
+
+	//Rebuilds and sorts the keys if anything changed, returns the renderers in draw order
+	//*cameraPosition is only used when depth sorting
+	const std::vector<RenderItem>& Update(const glm::vec3& cameraPosition);
+
+	//Packs a key, depth is 0-1 across the depth range
+	static uint64_t MakeKey(int renderLayer, uint16_t shaderId, uint16_t materialId, float depth);
+
+	//Getters
+	const std::vector<RenderItem>& GetItems() const;
+	bool IsDepthSorting() const;
+	//How many times the keys have been sorted, to see how often it actually happens
+	size_t GetSortCount() const;
+
+private:
+	void OnChanged(entt::registry& registry, entt::entity entity);
+
+	//Builds a key for every renderer
+	void BuildKeys(const glm::vec3& cameraPosition);
+	//Least significant digit first, 8 bits at a time, stable so equal keys keep their order
+	void RadixSort();
+
+	//Small ids for shaders and materials in the order they're first seen, so they fit in the key
+	uint16_t GetId(std::unordered_map<const void*, uint16_t>& ids, const void* pointer);
+
+	entt::registry& _registry;
+	std::vector<RenderItem> _items;
+	//Scratch space for the sort so it doesn't allocate every time
+	std::vector<RenderItem> _sortBuffer;
+
+	std::unordered_map<const void*, uint16_t> _shaderIds;
+	std::unordered_map<const void*, uint16_t> _materialIds;
+
+	bool _dirty = true;
+	bool _depthSorting = false;
+	float _maxDepth = 1000.0f;
+	size_t _sortCount = 0;
+};
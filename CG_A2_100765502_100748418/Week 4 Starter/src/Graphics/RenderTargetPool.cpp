@@ -0,0 +1,121 @@
+#include "RenderTargetPool.h"
+
+#include <algorithm>
+#include <utility>
+
+RenderTargetPool::RenderTargetPool()
+{
+}
+
+RenderTargetPool::~RenderTargetPool()
+{
+	Unload();
+}
+
+RenderTargetPool::RenderTargetPool(RenderTargetPool&& other) noexcept
+{
+	*this = std::move(other);
+}
+
+RenderTargetPool& RenderTargetPool::operator=(RenderTargetPool&& other) noexcept
+{
+	//Whatever this pool had goes to other and gets deleted with it
+	std::swap(_targets, other._targets);
+	std::swap(_width, other._width);
+	std::swap(_height, other._height);
+	std::swap(_resizePending, other._resizePending);
+	std::swap(_inUse, other._inUse);
+	std::swap(_peakInUse, other._peakInUse);
+	return *this;
+}
+
+Framebuffer* RenderTargetPool::Acquire(GLenum format, unsigned width, unsigned height)
+{
+	_inUse++;
+	_peakInUse = std::max(_peakInUse, _inUse);
+
+	//Reuse any free target of the same format
+	//*If the size moves it out of its bucket it renders to what it has until ApplyPendingResize
+	for (unsigned i = 0; i < _targets.size(); i++)
+	{
+		PooledTarget& pooled = _targets[i];
+		if (!pooled.InUse && pooled.Format == format)
+		{
+			pooled.InUse = true;
+			pooled.Target->Reshape(width, height);
+			return pooled.Target;
+		}
+	}
+
+	//Fullscreen passes never read depth so these are colour only
+	Framebuffer* target = new Framebuffer();
+	target->AddColorTarget(format);
+	target->Init(width, height);
+
+	_targets.push_back({ target, format, true });
+	return target;
+}
+
+void RenderTargetPool::Release(Framebuffer* target)
+{
+	for (unsigned i = 0; i < _targets.size(); i++)
+	{
+		if (_targets[i].Target == target && _targets[i].InUse)
+		{
+			_targets[i].InUse = false;
+			_inUse--;
+			return;
+		}
+	}
+}
+
+void RenderTargetPool::Reshape(unsigned width, unsigned height)
+{
+	_width = width;
+	_height = height;
+	_resizePending = true;
+}
+
+void RenderTargetPool::ApplyPendingResize()
+{
+	if (!_resizePending)
+		return;
+	_resizePending = false;
+
+	//Free targets past the peak were only ever needed once, don't reallocate them
+	size_t kept = 0;
+	for (unsigned i = 0; i < _targets.size();)
+	{
+		if (!_targets[i].InUse && kept >= _peakInUse)
+		{
+			_targets[i].Target->Unload();
+			delete _targets[i].Target;
+			_targets.erase(_targets.begin() + i);
+			continue;
+		}
+
+		kept++;
+		_targets[i].Target->Reshape(_width, _height);
+		_targets[i].Target->ApplyPendingResize();
+		i++;
+	}
+	_peakInUse = _inUse;
+}
+
+void RenderTargetPool::Unload()
+{
+	for (unsigned i = 0; i < _targets.size(); i++)
+	{
+		_targets[i].Target->Unload();
+		delete _targets[i].Target;
+	}
+
+	_targets.clear();
+	_inUse = 0;
+	_peakInUse = 0;
+}
+
+size_t RenderTargetPool::GetTargetCount() const
+{
+	return _targets.size();
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <vector>
+#include "Graphics/Framebuffer.h"
+
+//Shares colour-only framebuffers between passes that only need them for a moment
+//*A target released by one pass gets handed to the next pass that asks for the same format, reshaped to the size it wants
+//*New targets are only created when every target of that format is in use, never just because the size changed
+class RenderTargetPool
+{
+public:
+	RenderTargetPool();
+	//Deletes every pooled target
+	~RenderTargetPool();
+
+	//The pool owns its targets, but the graph holding it is a component the scene needs to be able to move around
+	RenderTargetPool(const RenderTargetPool& other) = delete;
+	RenderTargetPool& operator=(const RenderTargetPool& other) = delete;
+	RenderTargetPool(RenderTargetPool&& other) noexcept;
+	RenderTargetPool& operator=(RenderTargetPool&& other) noexcept;
+
+	//Gets a free target with this format reshaped to this size, creating one if there isn't one
+	//*Ask for the size the input actually renders at, so nothing grows past its bucket while a resize is pending
+	Framebuffer* Acquire(GLenum format, unsigned width, unsigned height);
+	//Hands a target back so it can be reused
+	void Release(Framebuffer* target);
+
+	//Remembers the new size, nothing is touched until ApplyPendingResize
+	void Reshape(unsigned width, unsigned height);
+	//Once a resize has settled, deletes targets beyond the most that were in use at once,
+	//then reallocates the rest at the new size
+	void ApplyPendingResize();
+	//Deletes every pooled target
+	void Unload();
+
+	//How many targets have been created
+	size_t GetTargetCount() const;
+
+private:
+	struct PooledTarget
+	{
+		Framebuffer* Target;
+		GLenum Format;
+		bool InUse;
+	};
+
+	std::vector<PooledTarget> _targets;
+
+	//Size from the last Reshape, applied by ApplyPendingResize
+	unsigned _width = 0;
+	unsigned _height = 0;
+	bool _resizePending = false;
+	//Targets in use right now, and the most there have been since the last resize
+	size_t _inUse = 0;
+	size_t _peakInUse = 0;
+};
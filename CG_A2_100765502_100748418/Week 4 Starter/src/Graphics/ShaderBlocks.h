@@ -0,0 +1,53 @@
+#pragma once
+#include <GLM/glm.hpp>
+
+//C++ side of the uniform blocks the scene shaders share
+//*These have to match the std140 layout of the blocks in the shaders, so vec3s are always followed by a float
+
+//Binding points of the blocks
+static const unsigned FRAME_DATA_BINDING = 0;
+static const unsigned SCENE_LIGHTING_BINDING = 1;
+//Shader storage binding of the DrawData array (see DrawDataBuffer)
+static const unsigned DRAW_DATA_BINDING = 0;
+//Vertex attribute the draw id is passed through, never enabled as an array so it reads the current value
+static const unsigned DRAW_ID_LOCATION = 8;
+
+//Camera and timing, changes every frame (FrameData block)
+struct FrameData
+{
+	glm::mat4 View;
+	glm::mat4 Projection;
+	glm::mat4 ViewProjection;
+	glm::mat4 InverseViewProjection;
+	//Projection * rotation of the view, for the skybox
+	glm::mat4 SkyboxMatrix;
+	glm::vec3 CamPos;
+	float Time;
+};
+static_assert(sizeof(FrameData) == 336, "FrameData doesn't match the std140 block");
+
+//The scene light and ambient, only changes when the settings do (SceneLighting block)
+struct SceneLighting
+{
+	glm::vec3 LightPos = glm::vec3(0.0f, 0.0f, 5.0f);
+	float AmbientLightStrength = 0.05f;
+	glm::vec3 LightCol = glm::vec3(0.9f, 0.85f, 0.5f);
+	float SpecularLightStrength = 1.0f;
+	glm::vec3 AmbientCol = glm::vec3(1.0f);
+	float AmbientStrength = 0.1f;
+	float AttenuationConstant = 1.0f;
+	float AttenuationLinear = 0.09f;
+	float AttenuationQuadratic = 0.032f;
+	float Padding = 0.0f;
+};
+static_assert(sizeof(SceneLighting) == 64, "SceneLighting doesn't match the std140 block");
+
+//Matrices for one draw, indexed by the draw id (std430, DrawDataBlock)
+struct DrawData
+{
+	glm::mat4 ModelViewProjection;
+	glm::mat4 Model;
+	//mat3 padded out to a mat4 so std430 and C++ agree, shaders only read the upper 3x3
+	glm::mat4 NormalMatrix;
+};
+static_assert(sizeof(DrawData) == 192, "DrawData doesn't match the std430 block");
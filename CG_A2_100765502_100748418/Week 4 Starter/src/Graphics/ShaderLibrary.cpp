@@ -0,0 +1,323 @@
+#include "ShaderLibrary.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <GLFW/glfw3.h>
+#include <Logging.h>
+
+#include "Utilities/MappedFile.h"
+#include "Utilities/Util.h"
+
+//From KHR_parallel_shader_compile, loaded by hand since it isn't core
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+typedef void (APIENTRY *MaxShaderCompilerThreadsFunc)(GLuint count);
+
+std::string ShaderLibrary::cacheDirectory = "shaders/cache/";
+std::unordered_map<uint64_t, GLuint> ShaderLibrary::_stages;
+std::unordered_map<uint64_t, ShaderLibrary::ProgramBinary> ShaderLibrary::_binaries;
+std::vector<ShaderLibrary::PendingProgram> ShaderLibrary::_pending;
+std::unordered_set<GLuint> ShaderLibrary::_pendingHandles;
+bool ShaderLibrary::_parallel = false;
+uint64_t ShaderLibrary::_driverHash = 0;
+int ShaderLibrary::_compileCount = 0;
+int ShaderLibrary::_linkCount = 0;
+int ShaderLibrary::_binaryLoadCount = 0;
+
+void ShaderLibrary::Init()
+{
+	//The ARB version is the same thing under another name
+	const char* names[][2] = {
+		{ "GL_KHR_parallel_shader_compile", "glMaxShaderCompilerThreadsKHR" },
+		{ "GL_ARB_parallel_shader_compile", "glMaxShaderCompilerThreadsARB" }
+	};
+	for (auto& name : names)
+	{
+		if (!glfwExtensionSupported(name[0]))
+			continue;
+
+		MaxShaderCompilerThreadsFunc maxThreads = reinterpret_cast<MaxShaderCompilerThreadsFunc>(glfwGetProcAddress(name[1]));
+		if (maxThreads != nullptr)
+		{
+			//0xFFFFFFFF lets the driver pick
+			maxThreads(0xFFFFFFFF);
+			_parallel = true;
+			LOG_INFO("Compiling shaders in parallel ({})", name[0]);
+			return;
+		}
+	}
+}
+
+void ShaderLibrary::Update()
+{
+	//Polling completion status never waits, unlike asking for the link status
+	for (size_t i = 0; i < _pending.size();)
+	{
+		GLint complete = GL_FALSE;
+		glGetProgramiv(_pending[i].Program->GetHandle(), GL_COMPLETION_STATUS_KHR, &complete);
+		if (complete == GL_FALSE)
+		{
+			i++;
+			continue;
+		}
+
+		Finish(_pending[i]);
+		_pending[i] = _pending.back();
+		_pending.pop_back();
+	}
+}
+
+void ShaderLibrary::WaitAll()
+{
+	for (const PendingProgram& pending : _pending)
+		Finish(pending);
+	_pending.clear();
+}
+
+bool ShaderLibrary::IsReady(const Shader::sptr& shader)
+{
+	return _pendingHandles.empty() || shader == nullptr || _pendingHandles.count(shader->GetHandle()) == 0;
+}
+
+Shader::sptr ShaderLibrary::Load(const std::string& vertexPath, const std::string& fragmentPath)
+{
+	return Create(ReadFile(vertexPath), ReadFile(fragmentPath), vertexPath + " + " + fragmentPath);
+}
+
+Shader::sptr ShaderLibrary::LoadWithFragmentSource(const std::string& vertexPath, const std::string& fragmentSource)
+{
+	return Create(ReadFile(vertexPath), fragmentSource, vertexPath + " + generated fragment");
+}
+
+Shader::sptr ShaderLibrary::Create(const std::string& vertexSource, const std::string& fragmentSource, const std::string& name)
+{
+	Shader::sptr shader = Shader::Create();
+	GLuint program = shader->GetHandle();
+
+	//Both stages and the driver, changing any of them means relinking
+	uint64_t hash = Util::HashBytes(vertexSource.data(), vertexSource.size(), GetDriverHash());
+	hash = Util::HashBytes(fragmentSource.data(), fragmentSource.size(), hash);
+
+	if (LoadBinary(program, hash))
+	{
+		_binaryLoadCount++;
+		return shader;
+	}
+
+	//Compiles and the link only get submitted here, nothing below asks the driver for a result
+	GLuint vertex = GetStage(vertexSource, GL_VERTEX_SHADER);
+	GLuint fragment = GetStage(fragmentSource, GL_FRAGMENT_SHADER);
+
+	glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	glAttachShader(program, vertex);
+	glAttachShader(program, fragment);
+	glLinkProgram(program);
+	//The stages stay alive in _stages for the next program that uses them
+	glDetachShader(program, vertex);
+	glDetachShader(program, fragment);
+	_linkCount++;
+
+	PendingProgram pending = { shader, vertex, fragment, hash, name };
+	if (_parallel)
+	{
+		_pending.push_back(pending);
+		_pendingHandles.insert(program);
+	}
+	else
+		Finish(pending);
+
+	return shader;
+}
+
+void ShaderLibrary::Finish(const PendingProgram& pending)
+{
+	GLuint program = pending.Program->GetHandle();
+	_pendingHandles.erase(program);
+
+	GLint linked = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &linked);
+	if (linked == GL_FALSE)
+	{
+		//A stage that didn't compile is the usual reason, those errors say more than the link log
+		LogStageErrors(pending.Vertex, pending.Name);
+		LogStageErrors(pending.Fragment, pending.Name);
+
+		GLint length = 0;
+		glGetProgramiv(program, GL_INFO_LOG_LENGTH, &length);
+		std::string log(std::max(length, 1), '\0');
+		glGetProgramInfoLog(program, length, nullptr, &log[0]);
+		LOG_ERROR("Failed to link {}:\n{}", pending.Name, log);
+		return;
+	}
+
+	SaveBinary(program, pending.Hash);
+}
+
+void ShaderLibrary::LogStageErrors(GLuint stage, const std::string& name)
+{
+	GLint compiled = GL_FALSE;
+	glGetShaderiv(stage, GL_COMPILE_STATUS, &compiled);
+	if (compiled == GL_TRUE)
+		return;
+
+	GLint length = 0;
+	GLint type = 0;
+	glGetShaderiv(stage, GL_INFO_LOG_LENGTH, &length);
+	glGetShaderiv(stage, GL_SHADER_TYPE, &type);
+	std::string log(std::max(length, 1), '\0');
+	glGetShaderInfoLog(stage, length, nullptr, &log[0]);
+	LOG_ERROR("Failed to compile {} stage of {}:\n{}", type == GL_VERTEX_SHADER ? "vertex" : "fragment", name, log);
+}
+
+void ShaderLibrary::Clear()
+{
+	WaitAll();
+	for (auto& stage : _stages)
+		glDeleteShader(stage.second);
+	_stages.clear();
+	_binaries.clear();
+}
+
+std::string ShaderLibrary::ReadFile(const std::string& path)
+{
+	MappedFile file;
+	if (!file.Open(path))
+	{
+		LOG_ERROR("Couldn't open shader {}", path);
+		return std::string();
+	}
+	return std::string(file.GetData(), file.GetSize());
+}
+
+GLuint ShaderLibrary::GetStage(const std::string& source, GLenum type)
+{
+	uint64_t hash = Util::HashBytes(source.data(), source.size(), Util::HashBytes(&type, sizeof(GLenum)));
+	auto existing = _stages.find(hash);
+	if (existing != _stages.end())
+		return existing->second;
+
+	//Errors are only looked at if a program using it fails to link (see Finish)
+	GLuint stage = glCreateShader(type);
+	const char* text = source.c_str();
+	glShaderSource(stage, 1, &text, nullptr);
+	glCompileShader(stage);
+	_compileCount++;
+
+	_stages[hash] = stage;
+	return stage;
+}
+
+uint64_t ShaderLibrary::GetDriverHash()
+{
+	if (_driverHash == 0)
+	{
+		_driverHash = Util::HashBytes(nullptr, 0);
+		GLenum strings[] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+		for (GLenum name : strings)
+		{
+			const char* value = reinterpret_cast<const char*>(glGetString(name));
+			if (value != nullptr)
+				_driverHash = Util::HashBytes(value, strlen(value), _driverHash);
+		}
+	}
+	return _driverHash;
+}
+
+bool ShaderLibrary::LoadBinary(GLuint program, uint64_t hash)
+{
+	auto loaded = _binaries.find(hash);
+	if (loaded == _binaries.end())
+	{
+		char hashName[17];
+		snprintf(hashName, sizeof(hashName), "%016llx", (unsigned long long)hash);
+		MappedFile file;
+		if (!file.Open(cacheDirectory + hashName + ".progbin") || file.GetSize() < sizeof(ProgramBinaryHeader))
+			return false;
+
+		//Make sure this is a binary of the version we write, for this exact program and driver
+		ProgramBinaryHeader header;
+		memcpy(&header, file.GetData(), sizeof(ProgramBinaryHeader));
+		ProgramBinaryHeader expected;
+		if (memcmp(header.Magic, expected.Magic, sizeof(header.Magic)) != 0 || header.Version != expected.Version ||
+			header.Hash != hash || file.GetSize() != sizeof(ProgramBinaryHeader) + header.Length)
+			return false;
+
+		ProgramBinary binary;
+		binary.Format = header.Format;
+		binary.Data.assign(file.GetData() + sizeof(ProgramBinaryHeader), file.GetData() + file.GetSize());
+		loaded = _binaries.emplace(hash, std::move(binary)).first;
+	}
+
+	glProgramBinary(program, loaded->second.Format, loaded->second.Data.data(), GLsizei(loaded->second.Data.size()));
+
+	//Drivers can still turn a binary down (after an update that kept the version string, for one)
+	GLint linked = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &linked);
+	if (linked == GL_FALSE)
+	{
+		_binaries.erase(loaded);
+		return false;
+	}
+	return true;
+}
+
+void ShaderLibrary::SaveBinary(GLuint program, uint64_t hash)
+{
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0)
+		return;
+
+	ProgramBinary binary;
+	binary.Data.resize(length);
+	glGetProgramBinary(program, length, nullptr, &binary.Format, binary.Data.data());
+
+	std::error_code error;
+	std::filesystem::create_directories(cacheDirectory, error);
+	char hashName[17];
+	snprintf(hashName, sizeof(hashName), "%016llx", (unsigned long long)hash);
+	std::string cachePath = cacheDirectory + hashName + ".progbin";
+	std::ofstream file(cachePath, std::ios::binary);
+	if (!file)
+		LOG_WARN("Could not write program binary {}", cachePath);
+	else
+	{
+		ProgramBinaryHeader header;
+		header.Hash = hash;
+		header.Format = binary.Format;
+		header.Length = uint32_t(length);
+		file.write(reinterpret_cast<const char*>(&header), sizeof(ProgramBinaryHeader));
+		file.write(binary.Data.data(), length);
+	}
+
+	_binaries[hash] = std::move(binary);
+}
+
+int ShaderLibrary::GetCompileCount()
+{
+	return _compileCount;
+}
+
+int ShaderLibrary::GetLinkCount()
+{
+	return _linkCount;
+}
+
+int ShaderLibrary::GetBinaryLoadCount()
+{
+	return _binaryLoadCount;
+}
+
+int ShaderLibrary::GetPendingCount()
+{
+	return int(_pending.size());
+}
+
+bool ShaderLibrary::IsParallel()
+{
+	return _parallel;
+}
@@ -0,0 +1,119 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <glad/glad.h>
+#include <Shader.h>
+
+//Header at the start of a cached program binary
+//*Followed by Length bytes from glGetProgramBinary
+struct ProgramBinaryHeader
+{
+	char Magic[4] = { 'P', 'R', 'G', 'B' };
+	uint32_t Version = 1;
+	//Hash of both stages' source and the driver it was linked by
+	uint64_t Hash = 0;
+	//Driver specific format from glGetProgramBinary
+	uint32_t Format = 0;
+	uint32_t Length = 0;
+};
+
+//Builds vertex + fragment programs with as little compiling and linking as possible
+//*Each stage is compiled once per run no matter how many programs use it (keyed on its source)
+//*Linked programs are saved with glGetProgramBinary and loaded with glProgramBinary on later runs,
+//keyed on the source and the driver, anything that doesn't match is compiled from source again
+//*Programs are still separate Shader objects, so uniforms set on one don't leak into another
+//*With KHR_parallel_shader_compile, compiles and links are only submitted and the driver builds them on its own threads,
+//Update picks up the finished ones, use IsReady to skip drawing with a program that isn't done yet
+//*Without it every program is finished before it's returned, like linking through Shader
+class ShaderLibrary abstract
+{
+public:
+	//Asks the driver for as many compiler threads as it wants, if it supports parallel compiles
+	//*Call once after GL is loaded and before any program is made
+	static void Init();
+	//Checks which submitted programs have finished, logs the ones that failed and caches the rest
+	//*Call once a frame, it never waits on the driver
+	static void Update();
+	//Waits for every submitted program to finish
+	static void WaitAll();
+
+	//False while the program is still being compiled or linked
+	static bool IsReady(const Shader::sptr& shader);
+
+	//Program from a vertex and fragment shader file
+	static Shader::sptr Load(const std::string& vertexPath, const std::string& fragmentPath);
+	//Program from a vertex shader file and fragment source made at runtime
+	static Shader::sptr LoadWithFragmentSource(const std::string& vertexPath, const std::string& fragmentSource);
+	//Program from vertex and fragment source
+	//*name is only used in error messages
+	static Shader::sptr Create(const std::string& vertexSource, const std::string& fragmentSource, const std::string& name);
+
+	//Deletes the compiled stages kept around for reuse, programs already made are unaffected
+	static void Clear();
+
+	//Folder that program binaries are written to and loaded from
+	static std::string cacheDirectory;
+
+	//Getters
+	//Stages actually compiled (not reused) this run
+	static int GetCompileCount();
+	//Programs linked from source this run
+	static int GetLinkCount();
+	//Programs created from a binary this run
+	static int GetBinaryLoadCount();
+	//Programs submitted but not finished yet
+	static int GetPendingCount();
+	//Whether the driver is compiling in parallel
+	static bool IsParallel();
+
+private:
+	//Reads a whole shader file, empty if it couldn't be opened
+	static std::string ReadFile(const std::string& path);
+	//Shader object for this source, submitting a compile if it hasn't been seen yet
+	static GLuint GetStage(const std::string& source, GLenum type);
+	//Hashes the driver strings, so a binary from another driver (or version) is never loaded
+	static uint64_t GetDriverHash();
+
+	//Loads a binary into program, from memory or disk, returns false if there isn't a valid one
+	static bool LoadBinary(GLuint program, uint64_t hash);
+	//Keeps a linked program's binary in memory and writes it to disk
+	static void SaveBinary(GLuint program, uint64_t hash);
+
+	//Binary of a linked program
+	struct ProgramBinary
+	{
+		GLenum Format;
+		std::vector<char> Data;
+	};
+
+	//A program that has been submitted to the driver but not checked yet
+	struct PendingProgram
+	{
+		Shader::sptr Program;
+		GLuint Vertex;
+		GLuint Fragment;
+		uint64_t Hash;
+		std::string Name;
+	};
+
+	//Checks a finished program's link status, logs why it failed or saves its binary
+	static void Finish(const PendingProgram& pending);
+	//Logs a stage's compile errors, if it has any
+	static void LogStageErrors(GLuint stage, const std::string& name);
+
+	//Compiled stages by hash of their source and type
+	static std::unordered_map<uint64_t, GLuint> _stages;
+	//Binaries loaded or saved this run, by program hash
+	static std::unordered_map<uint64_t, ProgramBinary> _binaries;
+	static std::vector<PendingProgram> _pending;
+	//Handles of the pending programs, for IsReady
+	static std::unordered_set<GLuint> _pendingHandles;
+	static bool _parallel;
+	static uint64_t _driverHash;
+	static int _compileCount;
+	static int _linkCount;
+	static int _binaryLoadCount;
+};
@@ -0,0 +1,48 @@
+#include "TextureSampling.h"
+
+#include <algorithm>
+
+//Core in 4.6, the same enum as EXT_texture_filter_anisotropic before that
+#ifndef GL_TEXTURE_MAX_ANISOTROPY
+#define GL_TEXTURE_MAX_ANISOTROPY 0x84FE
+#endif
+#ifndef GL_MAX_TEXTURE_MAX_ANISOTROPY
+#define GL_MAX_TEXTURE_MAX_ANISOTROPY 0x84FF
+#endif
+
+const float TextureSampling::DEFAULT_ANISOTROPY = 8.0f;
+float TextureSampling::_maxAnisotropy = 0.0f;
+
+Texture2DDescription TextureSampling::DefaultDescription()
+{
+	Texture2DDescription desc = Texture2DDescription();
+	desc.GenerateMipMaps = true;
+	desc.MinificationFilter = MinFilter::LinearMipLinear;
+	desc.MagnificationFilter = MagFilter::Linear;
+	desc.MaxAnisotropic = DEFAULT_ANISOTROPY;
+	return desc;
+}
+
+void TextureSampling::Apply(GLuint texture, bool generateMips, float anisotropy)
+{
+	if (texture == GL_NONE)
+		return;
+
+	if (generateMips)
+	{
+		glGenerateTextureMipmap(texture);
+		glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	}
+	glTextureParameterf(texture, GL_TEXTURE_MAX_ANISOTROPY, std::clamp(anisotropy, 1.0f, GetMaxAnisotropy()));
+}
+
+float TextureSampling::GetMaxAnisotropy()
+{
+	if (_maxAnisotropy == 0.0f)
+	{
+		glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY, &_maxAnisotropy);
+		//No support, leave it at 1 so asking for more does nothing
+		_maxAnisotropy = std::max(1.0f, _maxAnisotropy);
+	}
+	return _maxAnisotropy;
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <glad/glad.h>
+#include <Texture2D.h>
+
+//Mip chain and anisotropic filtering defaults for the textures we load
+//*Minifying a texture with no mips reads texels all over it for every pixel, that shimmers and thrashes the texture cache
+class TextureSampling abstract
+{
+public:
+	//Anisotropy used when a texture doesn't ask for something else, clamped to what the GPU supports
+	static const float DEFAULT_ANISOTROPY;
+
+	//Description with mips, trilinear filtering and DEFAULT_ANISOTROPY, size and format are left for the loader
+	static Texture2DDescription DefaultDescription();
+
+	//Builds the mip chain (if generateMips) and sets trilinear filtering and anisotropy on any texture
+	//*The texture's storage must already have room for the levels, immutable storage with 1 level just keeps 1
+	static void Apply(GLuint texture, bool generateMips, float anisotropy);
+
+	//Getters
+	//Highest anisotropy the GPU supports, 1 if it has none
+	static float GetMaxAnisotropy();
+
+private:
+	//Queried the first time it's needed, since it needs a context
+	static float _maxAnisotropy;
+};
@@ -0,0 +1,66 @@
+#include "UniformBuffer.h"
+
+#include <Logging.h>
+
+UniformBuffer::UniformBuffer()
+{
+}
+
+UniformBuffer::~UniformBuffer()
+{
+	Unload();
+}
+
+void UniformBuffer::Init(size_t size, GLuint binding)
+{
+	Unload();
+
+	_size = size;
+	_binding = binding;
+
+	glCreateBuffers(1, &_handle);
+	//Rewritten every frame from the CPU
+	glNamedBufferData(_handle, _size, nullptr, GL_DYNAMIC_DRAW);
+	Bind();
+}
+
+void UniformBuffer::Unload()
+{
+	if (_handle != GL_NONE)
+	{
+		glDeleteBuffers(1, &_handle);
+		_handle = GL_NONE;
+		_size = 0;
+	}
+}
+
+void UniformBuffer::Update(const void* data, size_t size, size_t offset)
+{
+	if (offset + size > _size)
+	{
+		LOG_ERROR("Uniform buffer update of {} bytes at {} is past the end of the buffer ({} bytes)", size, offset, _size);
+		return;
+	}
+
+	glNamedBufferSubData(_handle, offset, size, data);
+}
+
+void UniformBuffer::Bind() const
+{
+	glBindBufferBase(GL_UNIFORM_BUFFER, _binding, _handle);
+}
+
+GLuint UniformBuffer::GetHandle() const
+{
+	return _handle;
+}
+
+GLuint UniformBuffer::GetBinding() const
+{
+	return _binding;
+}
+
+size_t UniformBuffer::GetSize() const
+{
+	return _size;
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <cstddef>
+#include <glad/glad.h>
+
+//A block of uniforms shared by every shader that declares it
+//*Bound once to a fixed binding point, so updating it reaches every program without looking up names
+class UniformBuffer
+{
+public:
+	UniformBuffer();
+	//Deconstructor
+	//*Deletes the buffer
+	~UniformBuffer();
+
+	//A buffer owns its handle
+	UniformBuffer(const UniformBuffer& other) = delete;
+	UniformBuffer& operator=(const UniformBuffer& other) = delete;
+
+	//Creates a buffer of size bytes and binds it to the binding point
+	void Init(size_t size, GLuint binding);
+	//Deletes the buffer
+	void Unload();
+
+	//Replaces size bytes of the buffer starting at offset
+	void Update(const void* data, size_t size, size_t offset = 0);
+	//Replaces the whole buffer with a struct laid out to match the block (std140)
+	template <typename T>
+	void Update(const T& data)
+	{
+		Update(&data, sizeof(T));
+	}
+
+	//Binds the buffer to its binding point again (if something else was bound there)
+	void Bind() const;
+
+	//Getters
+	GLuint GetHandle() const;
+	GLuint GetBinding() const;
+	size_t GetSize() const;
+
+private:
+	GLuint _handle = GL_NONE;
+	GLuint _binding = 0;
+	size_t _size = 0;
+};
@@ -0,0 +1,163 @@
+#include "AsyncTextureLoader.h"
+
+#include <cstring>
+#include <filesystem>
+#include <stb_image.h>
+#include <Logging.h>
+
+#include "Utilities/JobSystem.h"
+#include "Utilities/DDSLoader.h"
+#include "Graphics/GLStateCache.h"
+
+GLuint AsyncTextureLoader::_unpackBuffer = GL_NONE;
+std::mutex AsyncTextureLoader::_decodedLock;
+std::deque<AsyncTextureLoader::DecodedImage> AsyncTextureLoader::_decoded;
+std::atomic<int> AsyncTextureLoader::_pending(0);
+size_t AsyncTextureLoader::_uploadedBytes = 0;
+
+Texture2D::sptr AsyncTextureLoader::LoadFromFile(const std::string& path, const Texture2DDescription& sampling)
+{
+	//A cooked copy is already in the GPU's format, there's nothing to decode so it's loaded right away
+	std::string cookedPath = DDSLoader::GetCookedPath(path);
+	if (std::filesystem::exists(cookedPath))
+	{
+		Texture2D::sptr cooked = DDSLoader::LoadFromFile(cookedPath, sampling);
+		if (cooked != nullptr)
+		{
+			//Mips were made by the cook tool, this only clamps the anisotropy to what the GPU supports
+			TextureSampling::Apply(cooked->GetHandle(), false, sampling.MaxAnisotropic);
+			return cooked;
+		}
+	}
+
+	//Placeholder, same as an empty texture cleared to white
+	//*Always RGBA8 so the real image can go into it whether it has alpha or not
+	//*Resizing to the real image keeps the rest of the description, so the mip chain gets allocated then
+	Texture2DDescription desc = sampling;
+	desc.Width = 1;
+	desc.Height = 1;
+	desc.Format = InternalFormat::RGBA8;
+	Texture2D::sptr texture = Texture2D::Create(desc);
+	texture->Clear();
+
+	//Match Texture2D::LoadFromFile, set here since the flag is shared by every thread
+	stbi_set_flip_vertically_on_load(true);
+
+	_pending++;
+	std::weak_ptr<Texture2D> target = texture;
+	bool generateMips = sampling.GenerateMipMaps;
+	float anisotropy = sampling.MaxAnisotropic;
+	JobSystem::Submit([target, path, generateMips, anisotropy]() {
+		DecodedImage image;
+		image.Texture = target;
+		image.GenerateMipMaps = generateMips;
+		image.Anisotropy = anisotropy;
+		image.Path = path;
+		int channels = 0;
+		image.Pixels = stbi_load(path.c_str(), &image.Width, &image.Height, &channels, 4);
+		if (image.Pixels == nullptr && stbi_failure_reason() != nullptr)
+			image.Error = stbi_failure_reason();
+
+		std::lock_guard<std::mutex> lock(_decodedLock);
+		_decoded.push_back(image);
+	});
+
+	return texture;
+}
+
+void AsyncTextureLoader::Update(size_t budgetBytes)
+{
+	_uploadedBytes = 0;
+
+	while (true)
+	{
+		DecodedImage image;
+		{
+			std::lock_guard<std::mutex> lock(_decodedLock);
+			if (_decoded.empty())
+				break;
+
+			//Over budget, leave the rest for next frame (the first one always goes so big images can't get stuck)
+			size_t bytes = size_t(_decoded.front().Width) * _decoded.front().Height * 4;
+			if (_uploadedBytes > 0 && _uploadedBytes + bytes > budgetBytes)
+				break;
+
+			image = _decoded.front();
+			_decoded.pop_front();
+		}
+
+		if (image.Pixels == nullptr)
+			LOG_WARN("Failed to load image {}: {}", image.Path, image.Error);
+		else
+		{
+			Upload(image);
+			_uploadedBytes += size_t(image.Width) * image.Height * 4;
+			stbi_image_free(image.Pixels);
+		}
+		_pending--;
+	}
+}
+
+void AsyncTextureLoader::Upload(const DecodedImage& image)
+{
+	Texture2D::sptr texture = image.Texture.lock();
+	//Nothing uses it anymore
+	if (texture == nullptr)
+		return;
+
+	if (_unpackBuffer == GL_NONE)
+		glCreateBuffers(1, &_unpackBuffer);
+
+	//Orphan the buffer so this doesn't wait on the last upload still reading it
+	size_t bytes = size_t(image.Width) * image.Height * 4;
+	glNamedBufferData(_unpackBuffer, bytes, nullptr, GL_STREAM_DRAW);
+	void* mapped = glMapNamedBufferRange(_unpackBuffer, 0, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	if (mapped == nullptr)
+	{
+		LOG_WARN("Could not map the unpack buffer for {}", image.Path);
+		return;
+	}
+	memcpy(mapped, image.Pixels, bytes);
+	glUnmapNamedBuffer(_unpackBuffer);
+
+	//Resizing recreates the texture, so the old name could be handed out again
+	GLStateCache::ForgetTexture(texture->GetHandle());
+
+	//With an unpack buffer bound the data pointer is an offset into it, the copy happens on the GPU's time
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _unpackBuffer);
+	texture->LoadData(image.Width, image.Height, PixelFormat::RGBA, PixelType::UnsignedByte, nullptr);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, GL_NONE);
+
+	//Mips are built from the uploaded level on the GPU
+	TextureSampling::Apply(texture->GetHandle(), image.GenerateMipMaps, image.Anisotropy);
+}
+
+void AsyncTextureLoader::Unload()
+{
+	{
+		std::lock_guard<std::mutex> lock(_decodedLock);
+		for (DecodedImage& image : _decoded)
+		{
+			if (image.Pixels != nullptr)
+				stbi_image_free(image.Pixels);
+		}
+		_decoded.clear();
+	}
+	_pending = 0;
+
+	if (_unpackBuffer != GL_NONE)
+	{
+		glDeleteBuffers(1, &_unpackBuffer);
+		_unpackBuffer = GL_NONE;
+	}
+}
+
+int AsyncTextureLoader::GetPendingCount()
+{
+	return _pending;
+}
+
+size_t AsyncTextureLoader::GetUploadedBytes()
+{
+	return _uploadedBytes;
+}
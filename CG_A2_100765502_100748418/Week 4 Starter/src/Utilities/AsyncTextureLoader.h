@@ -0,0 +1,65 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <glad/glad.h>
+#include <Texture2D.h>
+
+#include "Graphics/TextureSampling.h"
+
+//Loads textures without stalling the main thread
+//*Images are decoded on the job system, then copied to GL through a pixel unpack buffer by Update
+//*Until then the texture is a 1x1 white placeholder, so it can be given to materials straight away
+//*Decodes always use stb_image's global flip setting, don't load images on the main thread while any are in flight
+class AsyncTextureLoader abstract
+{
+public:
+	//Bytes uploaded per frame by default (at least one texture always goes up)
+	static const size_t DEFAULT_UPLOAD_BUDGET = 16 << 20;
+
+	//Returns the placeholder texture and queues the image to be decoded into it
+	//*If the image has been cooked (see DDSLoader::GetCookedPath) the compressed copy is loaded instead
+	//*Wrapping, filtering, mips and anisotropy come from sampling, its size and format are ignored
+	static Texture2D::sptr LoadFromFile(const std::string& path, const Texture2DDescription& sampling = TextureSampling::DefaultDescription());
+
+	//Uploads decoded images until budgetBytes have gone up this frame, call once a frame on the main thread
+	static void Update(size_t budgetBytes = DEFAULT_UPLOAD_BUDGET);
+	//Frees the unpack buffer and anything that hasn't been uploaded
+	//*Call after JobSystem::Shutdown so no decodes are still running
+	static void Unload();
+
+	//Getters
+	//Textures still decoding or waiting to upload
+	static int GetPendingCount();
+	//Bytes uploaded by the last Update
+	static size_t GetUploadedBytes();
+
+private:
+	//An image decoded on a worker, waiting for the main thread
+	struct DecodedImage
+	{
+		//The texture isn't kept alive just to be uploaded to
+		std::weak_ptr<Texture2D> Texture;
+		bool GenerateMipMaps = true;
+		float Anisotropy = 1.0f;
+		std::string Path;
+		unsigned char* Pixels = nullptr;
+		int Width = 0;
+		int Height = 0;
+		//Why stb_image couldn't decode it
+		const char* Error = "unknown error";
+	};
+
+	//Copies one image into the unpack buffer and from there into its texture
+	static void Upload(const DecodedImage& image);
+
+	static GLuint _unpackBuffer;
+	//Images that are ready to upload, filled by the workers
+	static std::mutex _decodedLock;
+	static std::deque<DecodedImage> _decoded;
+	static std::atomic<int> _pending;
+	static size_t _uploadedBytes;
+};
@@ -2,6 +2,13 @@
 
 GLFWwindow* BackendHandler::window = nullptr;
 std::vector<std::function<void()>> BackendHandler::imGuiCallbacks;
+UniformBuffer BackendHandler::frameUniforms;
+UniformBuffer BackendHandler::lightingUniforms;
+DrawDataBuffer BackendHandler::drawData;
+MeshPool BackendHandler::meshPool;
+const double BackendHandler::resizeSettleTime = 0.25;
+double BackendHandler::lastResizeTime = 0.0;
+bool BackendHandler::resizePending = false;
 
 
 void BackendHandler::GlDebugMessage(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* userParam)
@@ -32,20 +39,27 @@ bool BackendHandler::InitAll()
 {
 	Logger::Init();
 	Util::Init();
+	JobSystem::Init();
 
 	if (!InitGLFW())
 		return 1;
 	if (!InitGLAD())
 		return 1;
+	ShaderLibrary::Init();
 
 	Framebuffer::InitFullscreenQuad();
+	InitUniformBuffers();
+	InitMeshPool();
 
 	InitImGui();
 }
 
 void BackendHandler::GlfwWindowResizedCallback(GLFWwindow* window, int width, int height)
 {
-	glViewport(0, 0, width, height);
+	GLStateCache::Viewport(0, 0, width, height);
+	lastResizeTime = glfwGetTime();
+	resizePending = true;
+
 	Application::Instance().ActiveScene->Registry().view<Camera>().each([=](Camera& cam) 
 	{
 		cam.ResizeWindow(width, height);
@@ -66,6 +80,56 @@ void BackendHandler::GlfwWindowResizedCallback(GLFWwindow* window, int width, in
 		{
 			buf.Reshape(width, height);
 		});
+	Application::Instance().ActiveScene->Registry().view<ColorGradingStage>().each([=](ColorGradingStage& buf)
+		{
+			buf.Reshape(width, height);
+		});
+	Application::Instance().ActiveScene->Registry().view<PostProcessGraph>().each([=](PostProcessGraph& graph)
+		{
+			graph.Reshape(width, height);
+		});
+	Application::Instance().ActiveScene->Registry().view<DeferredRenderer>().each([=](DeferredRenderer& deferred)
+		{
+			deferred.Reshape(width, height);
+		});
+}
+
+void BackendHandler::UpdateDeferredResizes()
+{
+	//Wait for the window to stop changing size
+	if (!resizePending || glfwGetTime() - lastResizeTime < resizeSettleTime)
+		return;
+
+	resizePending = false;
+
+	Application::Instance().ActiveScene->Registry().view<Framebuffer>().each([=](Framebuffer& buf)
+	{
+		buf.ApplyPendingResize();
+	});
+	Application::Instance().ActiveScene->Registry().view<PostEffect>().each([=](PostEffect& buf)
+	{
+		buf.ApplyPendingResize();
+	});
+	Application::Instance().ActiveScene->Registry().view<GreyscaleEffect>().each([=](GreyscaleEffect& buf)
+	{
+		buf.ApplyPendingResize();
+	});
+	Application::Instance().ActiveScene->Registry().view<SepiaEffect>().each([=](SepiaEffect& buf)
+	{
+		buf.ApplyPendingResize();
+	});
+	Application::Instance().ActiveScene->Registry().view<ColorGradingStage>().each([=](ColorGradingStage& buf)
+	{
+		buf.ApplyPendingResize();
+	});
+	Application::Instance().ActiveScene->Registry().view<PostProcessGraph>().each([=](PostProcessGraph& graph)
+	{
+		graph.ApplyPendingResize();
+	});
+	Application::Instance().ActiveScene->Registry().view<DeferredRenderer>().each([=](DeferredRenderer& deferred)
+	{
+		deferred.ApplyPendingResize();
+	});
 }
 
 bool BackendHandler::InitGLFW()
@@ -175,23 +239,52 @@ void BackendHandler::RenderImGui()
 		// Restore our gl context
 		glfwMakeContextCurrent(window);
 	}
+
+	// ImGui sets its own program, textures, blending and so on
+	GLStateCache::Invalidate();
 }
 
-void BackendHandler::RenderVAO(const Shader::sptr& shader, const VertexArrayObject::sptr& vao, const glm::mat4& viewProjection, const Transform& transform)
+void BackendHandler::RenderVAO(const VertexArrayObject::sptr& vao, const glm::mat4& viewProjection, const Transform& transform)
 {
-	shader->SetUniformMatrix("u_ModelViewProjection", viewProjection * transform.WorldTransform());
-	shader->SetUniformMatrix("u_Model", transform.WorldTransform());
-	shader->SetUniformMatrix("u_NormalMatrix", transform.WorldNormalMatrix());
+	GLuint drawId = drawData.Push(viewProjection * transform.WorldTransform(), transform.WorldTransform(), transform.WorldNormalMatrix());
+	//Location 8 isn't an array in any VAO, so every vertex reads this value
+	glVertexAttribI1ui(DRAW_ID_LOCATION, drawId);
 	vao->Render();
+	//Render binds its own VAO
+	GLStateCache::InvalidateVertexArray();
+}
+
+void BackendHandler::InitUniformBuffers()
+{
+	frameUniforms.Init(sizeof(FrameData), FRAME_DATA_BINDING);
+	lightingUniforms.Init(sizeof(SceneLighting), SCENE_LIGHTING_BINDING);
+	lightingUniforms.Update(SceneLighting());
+	//Enough for a couple of regenerated environments without spilling into the next region
+	drawData.Init(4096, DRAW_DATA_BINDING);
+}
+
+void BackendHandler::UpdateFrameData(const glm::mat4& view, const glm::mat4& projection, float time)
+{
+	// These are the uniforms that update only once per frame, every shader reads them from the same block
+	FrameData data;
+	data.View = view;
+	data.Projection = projection;
+	data.ViewProjection = projection * view;
+	data.InverseViewProjection = glm::inverse(data.ViewProjection);
+	data.SkyboxMatrix = projection * glm::mat4(glm::mat3(view));
+	data.CamPos = glm::inverse(view) * glm::vec4(0, 0, 0, 1);
+	data.Time = time;
+	frameUniforms.Update(data);
+}
+
+void BackendHandler::UpdateSceneLighting(const SceneLighting& lighting)
+{
+	lightingUniforms.Update(lighting);
 }
 
-void BackendHandler::SetupShaderForFrame(const Shader::sptr& shader, const glm::mat4& view, const glm::mat4& projection)
+void BackendHandler::InitMeshPool()
 {
-	shader->Bind();
-	// These are the uniforms that update only once per frame
-	shader->SetUniformMatrix("u_View", view);
-	shader->SetUniformMatrix("u_ViewProjection", projection * view);
-	shader->SetUniformMatrix("u_SkyboxMatrix", projection * glm::mat4(glm::mat3(view)));
-	glm::vec3 camPos = glm::inverse(view) * glm::vec4(0, 0, 0, 1);
-	shader->SetUniform("u_CamPos", camPos);
+	//Room for the scene models and every environment model a few times over (~56MB)
+	meshPool.Init(1 << 20, 3 << 20);
+	MeshLoader::SetPool(&meshPool);
 }
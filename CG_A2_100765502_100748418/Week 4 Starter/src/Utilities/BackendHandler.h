@@ -4,6 +4,26 @@
 #include "Utilities/EnvironmentGenerator.h"
 #include "Graphics/Post/GreyscaleEffect.h"
 #include "Graphics//Post//SepiaEffect.h"
+#include "Graphics/Post/ColorGradingStage.h"
+#include "Graphics/Post/PostProcessGraph.h"
+#include "Graphics/DeferredRenderer.h"
+#include "Graphics/LightClusters.h"
+#include "Graphics/UniformBuffer.h"
+#include "Graphics/DrawDataBuffer.h"
+#include "Graphics/GLStateCache.h"
+#include "Graphics/TextureSampling.h"
+#include "Graphics/ShaderLibrary.h"
+#include "Graphics/MeshPool.h"
+#include "Graphics/IndirectRenderer.h"
+#include "Graphics/ShaderBlocks.h"
+#include "Graphics/CullingComponent.h"
+#include "Graphics/RenderQueue.h"
+#include "Utilities/MeshLoader.h"
+#include "Utilities/SpatialIndex.h"
+#include "Utilities/TransformSystem.h"
+#include "Utilities/JobSystem.h"
+#include "Utilities/AsyncTextureLoader.h"
+#include "Utilities/DDSLoader.h"
 #include "Graphics/LUT.h"
 
 #include <iostream>
@@ -46,7 +66,11 @@ public:
 	static bool InitAll();
 
 	//Window resize callback
+	//*Framebuffers only get reallocated once the window stops resizing, see UpdateDeferredResizes
 	static void GlfwWindowResizedCallback(GLFWwindow* window, int width, int height);
+	//Reallocates framebuffers that changed size bucket once resizing has settled
+	//*Call once a frame
+	static void UpdateDeferredResizes();
 
 	//Backend Graphic Init Functions
 	static bool InitGLFW();
@@ -58,9 +82,33 @@ public:
 	static void RenderImGui();
 
 	//Render our VAO
-	static void RenderVAO(const Shader::sptr& shader, const VertexArrayObject::sptr& vao, const glm::mat4& viewProjection, const Transform& transform);
-	static void SetupShaderForFrame(const Shader::sptr& shader, const glm::mat4& view, const glm::mat4& projection);
+	//*The matrices go into drawData and the shader picks them up by draw id
+	static void RenderVAO(const VertexArrayObject::sptr& vao, const glm::mat4& viewProjection, const Transform& transform);
+
+	//Creates the uniform blocks every scene shader shares, and the per draw buffer (see ShaderBlocks.h)
+	static void InitUniformBuffers();
+	//Uploads the camera and time to the FrameData block, once a frame
+	static void UpdateFrameData(const glm::mat4& view, const glm::mat4& projection, float time);
+	//Uploads the scene light to the SceneLighting block
+	static void UpdateSceneLighting(const SceneLighting& lighting);
+	//Creates the shared mesh buffers and has MeshLoader put meshes in them
+	static void InitMeshPool();
 
 	static GLFWwindow* window;
 	static std::vector<std::function<void()>> imGuiCallbacks;
+
+	//Shared uniform blocks
+	static UniformBuffer frameUniforms;
+	static UniformBuffer lightingUniforms;
+	//Per draw matrices, BeginFrame before the first draw and EndFrame after the last
+	static DrawDataBuffer drawData;
+	//Shared vertex and index buffers for indirect drawing
+	static MeshPool meshPool;
+
+	//Seconds without a resize before framebuffers get reallocated
+	static const double resizeSettleTime;
+	//When the window was last resized
+	static double lastResizeTime;
+	//Has the window been resized since framebuffers were last reallocated
+	static bool resizePending;
 };
\ No newline at end of file
@@ -0,0 +1,93 @@
+#pragma once
+#include <cstdint>
+
+//Layout of a DDS file, shared by the loader and the texture cook tool
+//*"DDS " then DDSHeader, then DDSHeaderDX10 if the pixel format's FourCC is "DX10", then every mip level largest first
+//*Cooked textures are stored bottom row first like the rest of our textures, not top down like most DDS files
+
+//Makes a FourCC code from 4 characters
+#define DDS_FOURCC(a, b, c, d) (uint32_t(a) | (uint32_t(b) << 8) | (uint32_t(c) << 16) | (uint32_t(d) << 24))
+
+static const uint32_t DDS_MAGIC = DDS_FOURCC('D', 'D', 'S', ' ');
+
+//DDSPixelFormat::Flags
+static const uint32_t DDPF_FOURCC = 0x4;
+//DDSHeader::Flags
+static const uint32_t DDSD_CAPS = 0x1;
+static const uint32_t DDSD_HEIGHT = 0x2;
+static const uint32_t DDSD_WIDTH = 0x4;
+static const uint32_t DDSD_PIXELFORMAT = 0x1000;
+static const uint32_t DDSD_MIPMAPCOUNT = 0x20000;
+static const uint32_t DDSD_LINEARSIZE = 0x80000;
+//DDSHeader::Caps
+static const uint32_t DDSCAPS_COMPLEX = 0x8;
+static const uint32_t DDSCAPS_TEXTURE = 0x1000;
+static const uint32_t DDSCAPS_MIPMAP = 0x400000;
+
+//DXGI formats we cook to and can load
+enum DXGIFormat : uint32_t
+{
+	DXGI_FORMAT_BC1_UNORM = 71,
+	DXGI_FORMAT_BC3_UNORM = 77,
+	DXGI_FORMAT_BC4_UNORM = 80,
+	DXGI_FORMAT_BC5_UNORM = 83
+};
+static const uint32_t D3D10_RESOURCE_DIMENSION_TEXTURE2D = 3;
+
+struct DDSPixelFormat
+{
+	uint32_t Size = 32;
+	uint32_t Flags = 0;
+	uint32_t FourCC = 0;
+	uint32_t RGBBitCount = 0;
+	uint32_t RBitMask = 0;
+	uint32_t GBitMask = 0;
+	uint32_t BBitMask = 0;
+	uint32_t ABitMask = 0;
+};
+
+struct DDSHeader
+{
+	uint32_t Size = 124;
+	uint32_t Flags = 0;
+	uint32_t Height = 0;
+	uint32_t Width = 0;
+	uint32_t PitchOrLinearSize = 0;
+	uint32_t Depth = 0;
+	uint32_t MipMapCount = 0;
+	uint32_t Reserved1[11] = {};
+	DDSPixelFormat PixelFormat;
+	uint32_t Caps = 0;
+	uint32_t Caps2 = 0;
+	uint32_t Caps3 = 0;
+	uint32_t Caps4 = 0;
+	uint32_t Reserved2 = 0;
+};
+
+struct DDSHeaderDX10
+{
+	uint32_t Format = 0;
+	uint32_t ResourceDimension = D3D10_RESOURCE_DIMENSION_TEXTURE2D;
+	uint32_t MiscFlag = 0;
+	uint32_t ArraySize = 1;
+	uint32_t MiscFlags2 = 0;
+};
+
+static_assert(sizeof(DDSHeader) == 124, "DDS header must match the file layout");
+static_assert(sizeof(DDSHeaderDX10) == 20, "DX10 header must match the file layout");
+
+//Bytes in one 4x4 block of a BC format, 0 if it isn't one we support
+inline uint32_t DDSBlockBytes(uint32_t dxgiFormat)
+{
+	switch (dxgiFormat)
+	{
+	case DXGI_FORMAT_BC1_UNORM:
+	case DXGI_FORMAT_BC4_UNORM:
+		return 8;
+	case DXGI_FORMAT_BC3_UNORM:
+	case DXGI_FORMAT_BC5_UNORM:
+		return 16;
+	default:
+		return 0;
+	}
+}
@@ -0,0 +1,138 @@
+#include "DDSLoader.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <Logging.h>
+
+#include "Utilities/MappedFile.h"
+
+//S3TC isn't core, but every desktop driver has it
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+std::string DDSLoader::cookedDirectory = "cooked";
+
+Texture2D::sptr DDSLoader::LoadFromFile(const std::string& path, const Texture2DDescription& sampling)
+{
+	MappedFile file;
+	if (!file.Open(path))
+	{
+		LOG_WARN("Couldn't open {}", path);
+		return nullptr;
+	}
+
+	const char* data = file.GetData();
+	size_t size = file.GetSize();
+	uint32_t magic = 0;
+	DDSHeader header;
+	if (size < sizeof(uint32_t) + sizeof(DDSHeader))
+	{
+		LOG_WARN("{} is too small to be a DDS", path);
+		return nullptr;
+	}
+	memcpy(&magic, data, sizeof(uint32_t));
+	memcpy(&header, data + sizeof(uint32_t), sizeof(DDSHeader));
+	size_t offset = sizeof(uint32_t) + sizeof(DDSHeader);
+	if (magic != DDS_MAGIC || header.Size != sizeof(DDSHeader) || (header.PixelFormat.Flags & DDPF_FOURCC) == 0)
+	{
+		LOG_WARN("{} is not a compressed DDS", path);
+		return nullptr;
+	}
+
+	//Newer files name the format in the DX10 header, older ones only have a FourCC
+	uint32_t format = 0;
+	switch (header.PixelFormat.FourCC)
+	{
+	case DDS_FOURCC('D', 'X', '1', '0'):
+	{
+		if (size < offset + sizeof(DDSHeaderDX10))
+			return nullptr;
+		DDSHeaderDX10 dx10;
+		memcpy(&dx10, data + offset, sizeof(DDSHeaderDX10));
+		offset += sizeof(DDSHeaderDX10);
+		if (dx10.ResourceDimension != D3D10_RESOURCE_DIMENSION_TEXTURE2D || dx10.ArraySize != 1)
+		{
+			LOG_WARN("{} is not a single 2D texture", path);
+			return nullptr;
+		}
+		format = dx10.Format;
+		break;
+	}
+	case DDS_FOURCC('D', 'X', 'T', '1'): format = DXGI_FORMAT_BC1_UNORM; break;
+	case DDS_FOURCC('D', 'X', 'T', '5'): format = DXGI_FORMAT_BC3_UNORM; break;
+	case DDS_FOURCC('A', 'T', 'I', '1'):
+	case DDS_FOURCC('B', 'C', '4', 'U'): format = DXGI_FORMAT_BC4_UNORM; break;
+	case DDS_FOURCC('A', 'T', 'I', '2'):
+	case DDS_FOURCC('B', 'C', '5', 'U'): format = DXGI_FORMAT_BC5_UNORM; break;
+	default: break;
+	}
+
+	GLenum glFormat = GetGLFormat(format);
+	uint32_t blockBytes = DDSBlockBytes(format);
+	if (glFormat == GL_NONE || header.Width == 0 || header.Height == 0)
+	{
+		LOG_WARN("{} uses a format we can't load", path);
+		return nullptr;
+	}
+	uint32_t levels = std::max(1u, header.MipMapCount);
+
+	//Make sure every level is actually in the file before creating anything
+	size_t needed = offset;
+	for (uint32_t level = 0; level < levels; level++)
+	{
+		uint32_t width = std::max(1u, header.Width >> level);
+		uint32_t height = std::max(1u, header.Height >> level);
+		needed += size_t((width + 3) / 4) * ((height + 3) / 4) * blockBytes;
+	}
+	if (needed > size)
+	{
+		LOG_WARN("{} is missing mip data", path);
+		return nullptr;
+	}
+
+	//The texture's storage is allocated in the compressed format, so there's no uncompressed copy anywhere
+	//*Starts from sampling so the cooked mips get the caller's filtering
+	Texture2DDescription desc = sampling;
+	desc.Width = header.Width;
+	desc.Height = header.Height;
+	desc.Format = static_cast<InternalFormat>(glFormat);
+	desc.GenerateMipMaps = levels > 1;
+	Texture2D::sptr texture = Texture2D::Create(desc);
+
+	GLuint handle = texture->GetHandle();
+	for (uint32_t level = 0; level < levels; level++)
+	{
+		uint32_t width = std::max(1u, header.Width >> level);
+		uint32_t height = std::max(1u, header.Height >> level);
+		GLsizei bytes = GLsizei(size_t((width + 3) / 4) * ((height + 3) / 4) * blockBytes);
+		glCompressedTextureSubImage2D(handle, level, 0, 0, width, height, glFormat, bytes, data + offset);
+		offset += bytes;
+	}
+	//Only sample the levels we have, the texture may have been given a longer chain
+	glTextureParameteri(handle, GL_TEXTURE_MAX_LEVEL, levels - 1);
+
+	return texture;
+}
+
+std::string DDSLoader::GetCookedPath(const std::string& imagePath)
+{
+	std::filesystem::path path(imagePath);
+	return (path.parent_path() / cookedDirectory / path.filename()).string() + ".dds";
+}
+
+GLenum DDSLoader::GetGLFormat(uint32_t dxgiFormat)
+{
+	switch (dxgiFormat)
+	{
+	case DXGI_FORMAT_BC1_UNORM: return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+	case DXGI_FORMAT_BC3_UNORM: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+	case DXGI_FORMAT_BC4_UNORM: return GL_COMPRESSED_RED_RGTC1;
+	case DXGI_FORMAT_BC5_UNORM: return GL_COMPRESSED_RG_RGTC2;
+	default: return GL_NONE;
+	}
+}
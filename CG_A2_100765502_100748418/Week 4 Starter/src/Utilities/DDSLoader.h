@@ -0,0 +1,28 @@
+#pragma once
+#include <string>
+#include <glad/glad.h>
+#include <Texture2D.h>
+
+#include "Utilities/DDSFormat.h"
+#include "Graphics/TextureSampling.h"
+
+//Loads block compressed (BC1/BC3/BC4/BC5) DDS files made by the TextureCook tool
+//*The blocks go to GL as they are with glCompressedTextureSubImage2D, every mip level comes from the file
+class DDSLoader abstract
+{
+public:
+	//Maps a DDS and creates a compressed texture from it, nullptr if it isn't a DDS we can load
+	//*Wrapping and filtering come from sampling, its size, format and mips come from the file
+	static Texture2D::sptr LoadFromFile(const std::string& path, const Texture2DDescription& sampling = TextureSampling::DefaultDescription());
+
+	//Where the cooked copy of an image goes, e.g. images/stone.jpg -> images/cooked/stone.jpg.dds
+	//*The source extension is kept so stone.png and stone.jpg don't cook to the same file
+	static std::string GetCookedPath(const std::string& imagePath);
+
+	//Folder next to the source images that cooked textures are kept in
+	static std::string cookedDirectory;
+
+private:
+	//GL internal format of a DXGI BC format, GL_NONE if it isn't supported
+	static GLenum GetGLFormat(uint32_t dxgiFormat);
+};
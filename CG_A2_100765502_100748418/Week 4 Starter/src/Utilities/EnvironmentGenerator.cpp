@@ -1,11 +1,17 @@
 #include "EnvironmentGenerator.h"
 
+#include <GLM/gtc/matrix_transform.hpp>
+#include <GLM/gtc/quaternion.hpp>
+
+bool EnvironmentGenerator::_instanced = true;
+const float EnvironmentGenerator::INSTANCE_CELL_SIZE = 10.0f;
+
 //The gameobject references to the spawned objects
 std::vector<std::vector<GameObject>> EnvironmentGenerator::_objectsSpawned;
 
 //Object information for being spawned
 std::vector<VertexArrayObject::sptr> EnvironmentGenerator::_vaosToSpawn;
-std::vector<bool> EnvironmentGenerator::_loadedIn;
+std::vector<AABB> EnvironmentGenerator::_boundsToSpawn;
 std::vector<ShaderMaterial::sptr> EnvironmentGenerator::_materialsForSpawning;
 std::vector<int> EnvironmentGenerator::_numToSpawn;
 std::vector<glm::vec2> EnvironmentGenerator::_spawnFromAll;
@@ -34,22 +40,48 @@ void EnvironmentGenerator::GenerateEnvironment()
 	{
 		std::vector<GameObject> temp;
 		{
-			//Load in this object vao
-			if (!_loadedIn[i])
+			if (_instanced)
 			{
-				VertexArrayObject::sptr vao = ObjLoader::LoadFromFile(_objectsToSpawn[i]);
-				_vaosToSpawn.push_back(vao);
-				_loadedIn[i] = true;
+				//The spawn area is split into a grid, one entity draws every copy in its cell
+				glm::vec2 areaSize = glm::abs(_spawnToAll[i] - _spawnFromAll[i]);
+				glm::vec2 areaMin = glm::min(_spawnFromAll[i], _spawnToAll[i]);
+				int cellsX = glm::max(1, int(glm::ceil(areaSize.x / INSTANCE_CELL_SIZE)));
+				int cellsY = glm::max(1, int(glm::ceil(areaSize.y / INSTANCE_CELL_SIZE)));
+				std::vector<std::vector<glm::mat4>> cellTransforms(cellsX * cellsY);
+				//Each cell gets culled as a whole
+				std::vector<AABB> cellBounds(cellsX * cellsY);
+				for (int j = 0; j < _numToSpawn[i]; j++)
+				{
+					glm::mat4 transform = GetRandomTransform(i);
+					glm::vec2 cell = glm::floor((glm::vec2(transform[3]) - areaMin) / INSTANCE_CELL_SIZE);
+					int cellIndex = glm::clamp(int(cell.y), 0, cellsY - 1) * cellsX + glm::clamp(int(cell.x), 0, cellsX - 1);
+
+					cellTransforms[cellIndex].push_back(transform);
+					cellBounds[cellIndex].Expand(_boundsToSpawn[i].Transformed(transform));
+				}
+
+				for (int j = 0; j < cellTransforms.size(); j++)
+				{
+					if (cellTransforms[j].empty())
+						continue;
+
+					temp.push_back(Application::Instance().ActiveScene->CreateEntity(_objectsToSpawn[i] + (std::to_string(temp.size() + 1))));
+					temp.back().emplace<InstancedRenderer>().SetMesh(_vaosToSpawn[i]).SetMaterial(_materialsForSpawning[i]).SetInstances(cellTransforms[j]);
+					temp.back().emplace<CullingComponent>(cellBounds[j]);
+				}
 			}
-
-			for (int j = 0; j < _numToSpawn[i]; j++)
+			else
 			{
-				temp.push_back(Application::Instance().ActiveScene->CreateEntity(_objectsToSpawn[i] + (std::to_string(j + 1))));
-				temp[j].emplace<RendererComponent>().SetMesh(_vaosToSpawn[i]).SetMaterial(_materialsForSpawning[i]);
-				//Randomly places
-				temp[j].get<Transform>().SetLocalPosition(glm::vec3(Util::GetRandomNumberBetween(_spawnFromAll[i],
-					_spawnToAll[i], _avoidFromAll[i], _avoidToAll[i]), 0.0f));
-				temp[j].get<Transform>().SetLocalRotation(Util::GetRandomNumberBetween(glm::vec3(0.f, 0.f, 0.f), glm::vec3(0.f, 0.f, 360.0f)));
+				for (int j = 0; j < _numToSpawn[i]; j++)
+				{
+					temp.push_back(Application::Instance().ActiveScene->CreateEntity(_objectsToSpawn[i] + (std::to_string(j + 1))));
+					temp[j].emplace<RendererComponent>().SetMesh(_vaosToSpawn[i]).SetMaterial(_materialsForSpawning[i]);
+					temp[j].emplace<CullingComponent>(_boundsToSpawn[i]);
+					//Randomly places
+					temp[j].get<Transform>().SetLocalPosition(glm::vec3(Util::GetRandomNumberBetween(_spawnFromAll[i],
+						_spawnToAll[i], _avoidFromAll[i], _avoidToAll[i]), 0.0f));
+					temp[j].get<Transform>().SetLocalRotation(Util::GetRandomNumberBetween(glm::vec3(0.f, 0.f, 0.f), glm::vec3(0.f, 0.f, 360.0f)));
+				}
 			}
 		}
 
@@ -58,6 +90,15 @@ void EnvironmentGenerator::GenerateEnvironment()
 	}
 }
 
+glm::mat4 EnvironmentGenerator::GetRandomTransform(int i)
+{
+	//Same placement as the per entity spawns
+	glm::vec3 position = glm::vec3(Util::GetRandomNumberBetween(_spawnFromAll[i], _spawnToAll[i], _avoidFromAll[i], _avoidToAll[i]), 0.0f);
+	glm::vec3 rotation = Util::GetRandomNumberBetween(glm::vec3(0.f, 0.f, 0.f), glm::vec3(0.f, 0.f, 360.0f));
+
+	return glm::translate(glm::mat4(1.0f), position) * glm::mat4_cast(glm::quat(glm::radians(rotation)));
+}
+
 void EnvironmentGenerator::CleanEnvironment()
 {
 	//Remove all the entities
@@ -77,6 +118,7 @@ void EnvironmentGenerator::CleanUpPointers()
 {
 	//Clear up vao references so the smart pointers can clear
 	_vaosToSpawn.clear();
+	_boundsToSpawn.clear();
 	//Clear up material references so the smart pointers can clear
 	_materialsForSpawning.clear();
 }
@@ -94,8 +136,9 @@ void EnvironmentGenerator::AddObjectToGeneration(std::string fileName, ShaderMat
 	}
 
 	//Loads in the mesh and adds to list
-	VertexArrayObject::sptr vao = ObjLoader::LoadFromFile(fileName);
-	_vaosToSpawn.push_back(vao);
+	MeshData mesh = MeshLoader::LoadFromFile(fileName);
+	_vaosToSpawn.push_back(mesh.Mesh);
+	_boundsToSpawn.push_back(mesh.Bounds);
 	//Adds material to list
 	_materialsForSpawning.push_back(objMat);
 	//Adds number to spawn for this object
@@ -109,8 +152,6 @@ void EnvironmentGenerator::AddObjectToGeneration(std::string fileName, ShaderMat
 
 	//Adds the filename to the list
 	_objectsToSpawn.push_back(fileName);
-	//Sets it as not loaded
-	_loadedIn.push_back(false);
 }
 
 void EnvironmentGenerator::RemoveObjectFromGeneration(std::string fileName)
@@ -124,9 +165,11 @@ void EnvironmentGenerator::RemoveObjectFromGeneration(std::string fileName)
 
 	//Erase from the vaosToSpawn, Materials, numbers, etc
 	_vaosToSpawn.erase(_vaosToSpawn.begin() + index);
-	_loadedIn.erase(_loadedIn.begin() + index);
+	_boundsToSpawn.erase(_boundsToSpawn.begin() + index);
 	_materialsForSpawning.erase(_materialsForSpawning.begin() + index);
 	_numToSpawn.erase(_numToSpawn.begin() + index);
+	_spawnFromAll.erase(_spawnFromAll.begin() + index);
+	_spawnToAll.erase(_spawnToAll.begin() + index);
 	_avoidFromAll.erase(_avoidFromAll.begin() + index);
 	_avoidToAll.erase(_avoidToAll.begin() + index);
 	
@@ -138,3 +181,13 @@ std::vector<std::string> EnvironmentGenerator::GetObjectsOnList()
 {
 	return _objectsToSpawn;
 }
+
+void EnvironmentGenerator::SetInstanced(bool instanced)
+{
+	_instanced = instanced;
+}
+
+bool EnvironmentGenerator::IsInstanced()
+{
+	return _instanced;
+}
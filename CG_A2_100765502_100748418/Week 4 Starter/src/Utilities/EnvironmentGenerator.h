@@ -1,12 +1,14 @@
 #pragma once
 #include <Scene.h>
 #include <Application.h>
-#include <ObjLoader.h>
 #include <RendererComponent.h>
 #include <Transform.h>
 #include <vector>
 
 #include "Utilities/Util.h"
+#include "Graphics/InstancedRenderer.h"
+#include "Graphics/CullingComponent.h"
+#include "Utilities/MeshLoader.h"
 
 class EnvironmentGenerator abstract
 {
@@ -29,13 +31,28 @@ public:
 	static void RemoveObjectFromGeneration(std::string fileName);
 
 	static std::vector<std::string> GetObjectsOnList();
+
+	//Instanced mode spawns an entity per object per grid cell with an InstancedRenderer holding every copy in that cell,
+	//instead of an entity with its own RendererComponent for each copy
+	//*Each cell is culled on its own, so only the parts of the spawn area on screen get drawn
+	//*Takes effect the next time the environment is generated
+	static void SetInstanced(bool instanced);
+	static bool IsInstanced();
 private:
+	//Builds the transform of a randomly placed copy of object i
+	static glm::mat4 GetRandomTransform(int i);
+
+	static bool _instanced;
+	//Width of the grid cells instanced copies are grouped into, smaller cells cull tighter but cost more draws
+	static const float INSTANCE_CELL_SIZE;
+
 	//The gameobjects spawned here
 	static std::vector<std::vector<GameObject>> _objectsSpawned;
 
 	//The vaos to spawn in
 	static std::vector<VertexArrayObject::sptr> _vaosToSpawn;
-	static std::vector<bool> _loadedIn;
+	//Bounds of each vao, for culling
+	static std::vector<AABB> _boundsToSpawn;
 	static std::vector<ShaderMaterial::sptr> _materialsForSpawning;
 	static std::vector<int> _numToSpawn;
 	static std::vector<glm::vec2> _spawnFromAll;
@@ -0,0 +1,169 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+
+std::vector<std::thread> JobSystem::_workers;
+std::vector<JobSystem::WorkerQueue*> JobSystem::_queues;
+std::mutex JobSystem::_sleepLock;
+std::condition_variable JobSystem::_wake;
+std::atomic<int> JobSystem::_pending(0);
+std::atomic<unsigned> JobSystem::_nextQueue(0);
+std::atomic<bool> JobSystem::_running(false);
+
+namespace
+{
+	//Queue of the worker running on this thread, the main thread uses the last queue
+	thread_local unsigned threadQueue = 0;
+}
+
+void JobSystem::Init(unsigned workerCount)
+{
+	if (_running)
+		return;
+
+	if (workerCount == 0)
+		workerCount = std::max(1u, std::thread::hardware_concurrency()) - 1;
+
+	//One queue per worker plus one for the main thread
+	for (unsigned i = 0; i <= workerCount; i++)
+		_queues.push_back(new WorkerQueue());
+	threadQueue = workerCount;
+
+	_running = true;
+	for (unsigned i = 0; i < workerCount; i++)
+		_workers.emplace_back(WorkerLoop, i);
+}
+
+void JobSystem::Shutdown()
+{
+	if (!_running)
+		return;
+
+	//Let the workers drain their queues before they stop
+	while (RunPendingJob(threadQueue)) {}
+
+	{
+		std::lock_guard<std::mutex> lock(_sleepLock);
+		_running = false;
+	}
+	_wake.notify_all();
+
+	for (std::thread& worker : _workers)
+		worker.join();
+	_workers.clear();
+
+	for (WorkerQueue* queue : _queues)
+		delete queue;
+	_queues.clear();
+}
+
+void JobSystem::Submit(Job job)
+{
+	//No workers, just run it
+	if (_queues.size() <= 1)
+	{
+		job();
+		return;
+	}
+
+	//Spread jobs over the queues, whoever is idle steals the rest
+	unsigned index = _nextQueue++ % unsigned(_queues.size());
+	{
+		std::lock_guard<std::mutex> lock(_queues[index]->Lock);
+		_queues[index]->Jobs.push_back(std::move(job));
+	}
+	_pending++;
+
+	std::lock_guard<std::mutex> lock(_sleepLock);
+	_wake.notify_one();
+}
+
+void JobSystem::ParallelFor(size_t count, size_t grainSize, const std::function<void(size_t begin, size_t end)>& body)
+{
+	if (count == 0)
+		return;
+
+	grainSize = std::max<size_t>(grainSize, 1);
+	size_t threads = _queues.size();
+	//Aim for a few chunks per thread so stealing can even out uneven jobs
+	size_t chunkSize = std::max(grainSize, (count + threads * 4 - 1) / (threads * 4));
+	size_t chunkCount = (count + chunkSize - 1) / chunkSize;
+
+	if (chunkCount <= 1 || threads <= 1)
+	{
+		body(0, count);
+		return;
+	}
+
+	std::atomic<size_t> remaining(chunkCount);
+	for (size_t chunk = 0; chunk < chunkCount; chunk++)
+	{
+		size_t begin = chunk * chunkSize;
+		size_t end = std::min(count, begin + chunkSize);
+		Submit([&body, &remaining, begin, end]() {
+			body(begin, end);
+			remaining--;
+		});
+	}
+
+	//Help out until every chunk is done
+	while (remaining > 0)
+	{
+		if (!RunPendingJob(threadQueue))
+			std::this_thread::yield();
+	}
+}
+
+unsigned JobSystem::GetWorkerCount()
+{
+	return unsigned(_workers.size());
+}
+
+void JobSystem::WorkerLoop(unsigned index)
+{
+	threadQueue = index;
+
+	while (true)
+	{
+		if (RunPendingJob(index))
+			continue;
+
+		std::unique_lock<std::mutex> lock(_sleepLock);
+		_wake.wait(lock, []() { return _pending > 0 || !_running; });
+		if (!_running && _pending == 0)
+			return;
+	}
+}
+
+bool JobSystem::RunPendingJob(unsigned index)
+{
+	size_t queueCount = _queues.size();
+	for (size_t i = 0; i < queueCount; i++)
+	{
+		WorkerQueue* queue = _queues[(index + i) % queueCount];
+		Job job;
+		{
+			std::lock_guard<std::mutex> lock(queue->Lock);
+			if (queue->Jobs.empty())
+				continue;
+
+			//Own queue from the back (most recent, still in cache), others from the front
+			if (i == 0)
+			{
+				job = std::move(queue->Jobs.back());
+				queue->Jobs.pop_back();
+			}
+			else
+			{
+				job = std::move(queue->Jobs.front());
+				queue->Jobs.pop_front();
+			}
+		}
+
+		_pending--;
+		job();
+		return true;
+	}
+
+	return false;
+}
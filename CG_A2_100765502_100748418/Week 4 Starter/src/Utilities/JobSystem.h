@@ -0,0 +1,54 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//Runs jobs across a pool of worker threads
+//*Each worker has its own queue and takes from the back of it, idle workers steal from the front of the others
+//*Jobs must not touch OpenGL, the context only belongs to the main thread
+class JobSystem abstract
+{
+public:
+	typedef std::function<void()> Job;
+
+	//Starts the workers, 0 uses one less than the number of cores (the main thread is the last one)
+	static void Init(unsigned workerCount = 0);
+	//Finishes queued jobs and joins the workers
+	static void Shutdown();
+
+	//Queues a job to run on any worker
+	static void Submit(Job job);
+	//Splits [0, count) into chunks of at least grainSize and runs them across the workers
+	//*The calling thread helps out and returns once every chunk is done
+	static void ParallelFor(size_t count, size_t grainSize, const std::function<void(size_t begin, size_t end)>& body);
+
+	//Getters
+	//Worker threads, not counting the main thread
+	static unsigned GetWorkerCount();
+
+private:
+	struct WorkerQueue
+	{
+		std::mutex Lock;
+		std::deque<Job> Jobs;
+	};
+
+	static void WorkerLoop(unsigned index);
+	//Runs one queued job, looking in queue index first then stealing from the rest
+	//*Returns false if every queue was empty
+	static bool RunPendingJob(unsigned index);
+
+	static std::vector<std::thread> _workers;
+	static std::vector<WorkerQueue*> _queues;
+	//Wakes sleeping workers when there's something to do
+	static std::mutex _sleepLock;
+	static std::condition_variable _wake;
+	//Jobs queued but not started
+	static std::atomic<int> _pending;
+	static std::atomic<unsigned> _nextQueue;
+	static std::atomic<bool> _running;
+};
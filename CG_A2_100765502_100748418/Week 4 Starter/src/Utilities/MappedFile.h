@@ -0,0 +1,42 @@
+#pragma once
+#include <string>
+#include <cstddef>
+
+//Read only view of a file mapped into memory
+//*The OS pages the contents in as they are touched, so nothing is copied up front
+class MappedFile
+{
+public:
+	MappedFile();
+	//Unmaps the file if it is still open
+	~MappedFile();
+
+	//A mapping has exactly one owner
+	MappedFile(const MappedFile& other) = delete;
+	MappedFile& operator=(const MappedFile& other) = delete;
+
+	//Maps the file at path, returns false if it doesn't exist or is empty
+	bool Open(const std::string& path);
+	//Unmaps the file
+	void Close();
+
+	//Getters
+	const char* GetData() const;
+	size_t GetSize() const;
+	bool IsOpen() const;
+
+private:
+	//Start of the mapped view
+	const char* _data = nullptr;
+	//Size of the file in bytes
+	size_t _size = 0;
+
+#ifdef _WIN32
+	//File and file mapping handles
+	void* _file = nullptr;
+	void* _mapping = nullptr;
+#else
+	//File descriptor
+	int _file = -1;
+#endif
+};
@@ -0,0 +1,344 @@
+#include "MeshLoader.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <MeshBuilder.h>
+#include <VertexTypes.h>
+#include <Logging.h>
+
+#include "Utilities/MappedFile.h"
+#include "Utilities/Util.h"
+
+std::string MeshLoader::cacheDirectory = "models/cache/";
+MeshPool* MeshLoader::_pool = nullptr;
+std::unordered_map<std::string, MeshData> MeshLoader::_loadedMeshes;
+
+namespace
+{
+	//Position, uv, normal and material indices of one face corner
+	struct ObjCorner
+	{
+		int Position;
+		int UV;
+		int Normal;
+		int Material;
+
+		bool operator==(const ObjCorner& other) const
+		{
+			return Position == other.Position && UV == other.UV && Normal == other.Normal && Material == other.Material;
+		}
+	};
+
+	struct ObjCornerHash
+	{
+		size_t operator()(const ObjCorner& corner) const
+		{
+			size_t hash = std::hash<int>()(corner.Position);
+			hash = hash * 31 + std::hash<int>()(corner.UV);
+			hash = hash * 31 + std::hash<int>()(corner.Normal);
+			return hash * 31 + std::hash<int>()(corner.Material);
+		}
+	};
+
+	//Reads the diffuse colour (Kd) of every material in a .mtl
+	void ParseMtl(const std::string& filename, std::unordered_map<std::string, glm::vec3>& colors)
+	{
+		std::ifstream file(filename);
+		if (!file.is_open())
+		{
+			LOG_WARN("Couldn't open material library {}", filename);
+			return;
+		}
+
+		std::string line;
+		std::string type;
+		std::string current;
+		while (std::getline(file, line))
+		{
+			std::istringstream stream(line);
+			if (!(stream >> type))
+				continue;
+
+			if (type == "newmtl")
+			{
+				stream >> current;
+				colors[current] = glm::vec3(1.0f);
+			}
+			else if (type == "Kd" && !current.empty())
+			{
+				glm::vec3 color;
+				if (stream >> color.r >> color.g >> color.b)
+					colors[current] = color;
+			}
+		}
+	}
+
+	//Turns a 1 based (or negative, counting back from the end) OBJ index into a 0 based one, -1 if missing
+	int ResolveIndex(const std::string& text, size_t count)
+	{
+		if (text.empty())
+			return -1;
+		int index = std::stoi(text);
+		return index < 0 ? int(count) + index : index - 1;
+	}
+}
+
+MeshData MeshLoader::LoadFromFile(const std::string& filename)
+{
+	//Already loaded? share it
+	auto loaded = _loadedMeshes.find(filename);
+	if (loaded != _loadedMeshes.end())
+		return loaded->second;
+
+	MeshData result;
+
+	//Map the .obj, we only need the bytes to hash them unless there's no compiled version
+	MappedFile obj;
+	if (!obj.Open(filename))
+	{
+		LOG_WARN("Couldn't open mesh {}", filename);
+		return result;
+	}
+	uint64_t hash = Util::HashBytes(obj.GetData(), obj.GetSize());
+
+	char hashName[17];
+	snprintf(hashName, sizeof(hashName), "%016llx", (unsigned long long)hash);
+	std::string cachePath = cacheDirectory + hashName + ".meshbin";
+
+	//Fall back to parsing the text, then compile it so next launch can skip this
+	if (!LoadCompiled(cachePath, hash, result))
+	{
+		std::vector<PoolVertex> vertices;
+		std::vector<uint32_t> indices;
+		if (!ParseObj(filename, vertices, indices, result.Bounds) || indices.empty())
+		{
+			LOG_WARN("{} has no faces", filename);
+			return result;
+		}
+
+		WriteCompiled(cachePath, hash, vertices, indices, result.Bounds);
+		Upload(vertices.data(), vertices.size(), indices.data(), indices.size(), result);
+	}
+
+	_loadedMeshes[filename] = result;
+	return result;
+}
+
+bool MeshLoader::ParseObj(const std::string& filename, std::vector<PoolVertex>& vertices, std::vector<uint32_t>& indices, AABB& bounds)
+{
+	std::ifstream file(filename);
+	if (!file.is_open())
+	{
+		LOG_WARN("Couldn't open {} to parse it", filename);
+		return false;
+	}
+
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec2> uvs;
+	std::vector<glm::vec3> normals;
+	std::unordered_map<ObjCorner, uint32_t, ObjCornerHash> cornerToVertex;
+	//Materials from the .mtl, and the colour of each one used so far (by index, so corners can be keyed on it)
+	std::unordered_map<std::string, glm::vec3> materialColors;
+	std::vector<glm::vec3> usedColors = { glm::vec3(1.0f) };
+	std::unordered_map<std::string, int> usedMaterials;
+	int material = 0;
+	//Vertices without a normal in the file get the sum of their faces' normals
+	std::vector<bool> missingNormal;
+	bool anyMissingNormals = false;
+
+	std::string line;
+	std::string type;
+	while (std::getline(file, line))
+	{
+		std::istringstream stream(line);
+		if (!(stream >> type))
+			continue;
+
+		if (type == "v")
+		{
+			glm::vec3 position;
+			stream >> position.x >> position.y >> position.z;
+			positions.push_back(position);
+			bounds.Expand(position);
+		}
+		else if (type == "vt")
+		{
+			glm::vec2 uv;
+			stream >> uv.x >> uv.y;
+			uvs.push_back(uv);
+		}
+		else if (type == "vn")
+		{
+			glm::vec3 normal;
+			stream >> normal.x >> normal.y >> normal.z;
+			normals.push_back(normal);
+		}
+		else if (type == "mtllib")
+		{
+			//Relative to the .obj
+			std::string library;
+			stream >> library;
+			ParseMtl((std::filesystem::path(filename).parent_path() / library).string(), materialColors);
+		}
+		else if (type == "usemtl")
+		{
+			std::string name;
+			stream >> name;
+			auto used = usedMaterials.find(name);
+			if (used == usedMaterials.end())
+			{
+				auto color = materialColors.find(name);
+				usedColors.push_back(color == materialColors.end() ? glm::vec3(1.0f) : color->second);
+				used = usedMaterials.emplace(name, int(usedColors.size()) - 1).first;
+			}
+			material = used->second;
+		}
+		else if (type == "f")
+		{
+			std::vector<uint32_t> face;
+			std::string cornerText;
+			while (stream >> cornerText)
+			{
+				//v, v/vt, v//vn or v/vt/vn
+				size_t firstSlash = cornerText.find('/');
+				size_t secondSlash = firstSlash == std::string::npos ? std::string::npos : cornerText.find('/', firstSlash + 1);
+				ObjCorner corner;
+				corner.Position = ResolveIndex(cornerText.substr(0, firstSlash), positions.size());
+				corner.UV = firstSlash == std::string::npos ? -1 : ResolveIndex(cornerText.substr(firstSlash + 1, secondSlash - firstSlash - 1), uvs.size());
+				corner.Normal = secondSlash == std::string::npos ? -1 : ResolveIndex(cornerText.substr(secondSlash + 1), normals.size());
+				corner.Material = material;
+
+				if (corner.Position < 0 || corner.Position >= int(positions.size()))
+				{
+					LOG_WARN("{} has a face with a bad position index, skipping it", filename);
+					face.clear();
+					break;
+				}
+
+				auto it = cornerToVertex.find(corner);
+				if (it == cornerToVertex.end())
+				{
+					PoolVertex vertex;
+					vertex.Position = positions[corner.Position];
+					vertex.Color = usedColors[material];
+					vertex.UV = corner.UV >= 0 && corner.UV < int(uvs.size()) ? uvs[corner.UV] : glm::vec2(0.0f);
+					vertex.Normal = corner.Normal >= 0 && corner.Normal < int(normals.size()) ? normals[corner.Normal] : glm::vec3(0.0f);
+					missingNormal.push_back(corner.Normal < 0);
+					anyMissingNormals |= corner.Normal < 0;
+
+					it = cornerToVertex.emplace(corner, uint32_t(vertices.size())).first;
+					vertices.push_back(vertex);
+				}
+				face.push_back(it->second);
+			}
+
+			for (size_t i = 2; i < face.size(); i++)
+			{
+				indices.push_back(face[0]);
+				indices.push_back(face[i - 1]);
+				indices.push_back(face[i]);
+			}
+		}
+	}
+
+	if (anyMissingNormals)
+	{
+		for (size_t i = 0; i + 2 < indices.size(); i += 3)
+		{
+			const glm::vec3& a = vertices[indices[i]].Position;
+			glm::vec3 faceNormal = glm::cross(vertices[indices[i + 1]].Position - a, vertices[indices[i + 2]].Position - a);
+			for (size_t corner = i; corner < i + 3; corner++)
+			{
+				if (missingNormal[indices[corner]])
+					vertices[indices[corner]].Normal += faceNormal;
+			}
+		}
+		for (size_t i = 0; i < vertices.size(); i++)
+		{
+			if (missingNormal[i] && glm::dot(vertices[i].Normal, vertices[i].Normal) > 0.0f)
+				vertices[i].Normal = glm::normalize(vertices[i].Normal);
+		}
+	}
+
+	return true;
+}
+
+void MeshLoader::SetPool(MeshPool* pool)
+{
+	_pool = pool;
+}
+
+void MeshLoader::Clear()
+{
+	_loadedMeshes.clear();
+}
+
+bool MeshLoader::LoadCompiled(const std::string& cachePath, uint64_t hash, MeshData& result)
+{
+	MappedFile compiled;
+	if (!compiled.Open(cachePath) || compiled.GetSize() < sizeof(MeshBinaryHeader))
+		return false;
+
+	//Make sure this is a compiled mesh of the version we write, made from this exact .obj
+	MeshBinaryHeader header;
+	memcpy(&header, compiled.GetData(), sizeof(MeshBinaryHeader));
+	MeshBinaryHeader expected;
+	size_t vertexBytes = size_t(header.VertexCount) * sizeof(PoolVertex);
+	size_t indexBytes = size_t(header.IndexCount) * sizeof(uint32_t);
+	if (memcmp(header.Magic, expected.Magic, sizeof(header.Magic)) != 0 || header.Version != expected.Version ||
+		header.Hash != hash || compiled.GetSize() != sizeof(MeshBinaryHeader) + vertexBytes + indexBytes)
+		return false;
+
+	result.Bounds = AABB();
+	result.Bounds.Expand(glm::vec3(header.BoundsMin[0], header.BoundsMin[1], header.BoundsMin[2]));
+	result.Bounds.Expand(glm::vec3(header.BoundsMax[0], header.BoundsMax[1], header.BoundsMax[2]));
+
+	//No parsing, the vertices and indices are read straight out of the mapped pages (see Upload)
+	const char* data = compiled.GetData() + sizeof(MeshBinaryHeader);
+	Upload(reinterpret_cast<const PoolVertex*>(data), header.VertexCount,
+		reinterpret_cast<const uint32_t*>(data + vertexBytes), header.IndexCount, result);
+	return true;
+}
+
+void MeshLoader::WriteCompiled(const std::string& cachePath, uint64_t hash, const std::vector<PoolVertex>& vertices, const std::vector<uint32_t>& indices, const AABB& bounds)
+{
+	std::error_code error;
+	std::filesystem::create_directories(cacheDirectory, error);
+
+	std::ofstream compiled(cachePath, std::ios::binary);
+	if (!compiled)
+	{
+		LOG_WARN("Could not write compiled mesh {}", cachePath);
+		return;
+	}
+
+	MeshBinaryHeader header;
+	header.Hash = hash;
+	header.VertexCount = uint32_t(vertices.size());
+	header.IndexCount = uint32_t(indices.size());
+	for (int i = 0; i < 3; i++)
+	{
+		header.BoundsMin[i] = bounds.Min[i];
+		header.BoundsMax[i] = bounds.Max[i];
+	}
+	compiled.write(reinterpret_cast<const char*>(&header), sizeof(MeshBinaryHeader));
+	compiled.write(reinterpret_cast<const char*>(vertices.data()), vertices.size() * sizeof(PoolVertex));
+	compiled.write(reinterpret_cast<const char*>(indices.data()), indices.size() * sizeof(uint32_t));
+}
+
+void MeshLoader::Upload(const PoolVertex* vertices, size_t vertexCount, const uint32_t* indices, size_t indexCount, MeshData& result)
+{
+	//Standalone VAO for the renderers that draw one mesh at a time
+	//*VertexArrayObject comes from the framework, so this still copies through MeshBuilder, only the pool copy is uploaded from vertices as-is
+	MeshBuilder<VertexPosNormTexCol> builder;
+	for (size_t i = 0; i < vertexCount; i++)
+		builder.AddVertex(VertexPosNormTexCol(vertices[i].Position, vertices[i].Normal, vertices[i].UV, glm::vec4(vertices[i].Color, 1.0f)));
+	for (size_t i = 0; i + 2 < indexCount; i += 3)
+		builder.AddIndexTri(indices[i], indices[i + 1], indices[i + 2]);
+	result.Mesh = builder.Bake();
+
+	if (_pool != nullptr)
+		result.PoolMesh = _pool->AddMesh(vertices, vertexCount, indices, indexCount, result.Mesh);
+}
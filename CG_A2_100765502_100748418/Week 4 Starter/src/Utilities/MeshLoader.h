@@ -0,0 +1,68 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <VertexArrayObject.h>
+
+#include "Graphics/Bounds.h"
+#include "Graphics/MeshPool.h"
+
+//A loaded mesh along with the bounds of its vertices
+struct MeshData
+{
+	VertexArrayObject::sptr Mesh;
+	AABB Bounds;
+	//Id of the copy in the mesh pool, -1 if it isn't pooled
+	int PoolMesh = -1;
+};
+
+//Header at the start of a compiled (binary) mesh
+//*Followed by VertexCount PoolVertex then IndexCount uint32 indices, ready to upload
+struct MeshBinaryHeader
+{
+	char Magic[4] = { 'M', 'S', 'H', 'B' };
+	uint32_t Version = 1;
+	//Content hash of the .obj this was compiled from
+	uint64_t Hash = 0;
+	uint32_t VertexCount = 0;
+	uint32_t IndexCount = 0;
+	float BoundsMin[3] = { 0.0f, 0.0f, 0.0f };
+	float BoundsMax[3] = { 0.0f, 0.0f, 0.0f };
+};
+
+class MeshLoader abstract
+{
+public:
+	//Loads an OBJ, each path is only ever loaded once, later calls get the same mesh
+	//*The first load compiles it into cacheDirectory, later launches map that instead of parsing the text
+	//*If a pool has been set, the mesh also goes into it so it can be drawn indirectly
+	static MeshData LoadFromFile(const std::string& filename);
+
+	//Parses an OBJ into indexed triangles in the pool's vertex layout
+	//*Faces with more than 3 corners are fanned, corners that share a position, uv, normal and material share a vertex
+	//*Vertex colours come from the diffuse (Kd) of the material in the .mtl
+	//*Returns false if the file couldn't be opened
+	static bool ParseObj(const std::string& filename, std::vector<PoolVertex>& vertices, std::vector<uint32_t>& indices, AABB& bounds);
+
+	//Pool that LoadFromFile adds meshes to, nullptr to stop pooling
+	static void SetPool(MeshPool* pool);
+	//Drops the loaded meshes so their VAOs can be freed
+	static void Clear();
+
+	//Folder that compiled meshes are written to and mapped from
+	//*Keyed on the .obj contents only, clear it after editing a .mtl
+	static std::string cacheDirectory;
+
+private:
+	//Tries to map a compiled mesh and upload it, returns false if there isn't a valid one
+	static bool LoadCompiled(const std::string& cachePath, uint64_t hash, MeshData& result);
+	//Writes parsed data out as a compiled mesh
+	static void WriteCompiled(const std::string& cachePath, uint64_t hash, const std::vector<PoolVertex>& vertices, const std::vector<uint32_t>& indices, const AABB& bounds);
+	//Creates the VAO from the vertex and index data, and the pool copy straight from it
+	static void Upload(const PoolVertex* vertices, size_t vertexCount, const uint32_t* indices, size_t indexCount, MeshData& result);
+
+	static MeshPool* _pool;
+	//Every mesh loaded so far, by path
+	static std::unordered_map<std::string, MeshData> _loadedMeshes;
+};
@@ -0,0 +1,92 @@
+#include "SpatialIndex.h"
+
+SpatialIndex::SpatialIndex(entt::registry& registry, float margin)
+	: _registry(registry), _tree(margin)
+{
+	_registry.on_destroy<CullingComponent>().connect<&SpatialIndex::OnDestroy>(*this);
+}
+
+SpatialIndex::~SpatialIndex()
+{
+	_registry.on_destroy<CullingComponent>().disconnect<&SpatialIndex::OnDestroy>(*this);
+}
+
+void SpatialIndex::Update(const std::vector<entt::entity>& changed)
+{
+	for (entt::entity entity : changed)
+	{
+		CullingComponent* culling = _registry.try_get<CullingComponent>(entity);
+		if (culling == nullptr || !culling->WorldBounds.IsValid())
+			continue;
+
+		if (culling->Proxy == AABBTree::NULL_NODE)
+			culling->Proxy = _tree.CreateProxy(culling->WorldBounds, static_cast<uint32_t>(entity));
+		else
+			_tree.MoveProxy(culling->Proxy, culling->WorldBounds);
+	}
+}
+
+void SpatialIndex::QueryFrustum(const Frustum& frustum, const std::function<void(entt::entity)>& callback) const
+{
+	_tree.QueryFrustum(frustum, [&](uint32_t userData) {
+		if (frustum.Intersects(GetCulling(userData).WorldBounds))
+			callback(static_cast<entt::entity>(userData));
+	});
+}
+
+void SpatialIndex::QuerySphere(const BoundingSphere& sphere, const std::function<void(entt::entity)>& callback) const
+{
+	_tree.QuerySphere(sphere, [&](uint32_t userData) {
+		if (sphere.Overlaps(GetCulling(userData).WorldBounds))
+			callback(static_cast<entt::entity>(userData));
+	});
+}
+
+void SpatialIndex::QueryBox(const AABB& box, const std::function<void(entt::entity)>& callback) const
+{
+	_tree.QueryBox(box, [&](uint32_t userData) {
+		if (box.Overlaps(GetCulling(userData).WorldBounds))
+			callback(static_cast<entt::entity>(userData));
+	});
+}
+
+bool SpatialIndex::RayCast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, entt::entity& hit, float& distance) const
+{
+	glm::vec3 inverseDirection = 1.0f / direction;
+	bool found = false;
+
+	_tree.RayCast(origin, direction, maxDistance, [&](uint32_t userData, float fatDistance) {
+		float hitDistance;
+		if (GetCulling(userData).WorldBounds.IntersectsRay(origin, inverseDirection, maxDistance, hitDistance))
+		{
+			//Only look for closer hits from now on
+			maxDistance = hitDistance;
+			hit = static_cast<entt::entity>(userData);
+			distance = hitDistance;
+			found = true;
+		}
+		return maxDistance;
+	});
+
+	return found;
+}
+
+const AABBTree& SpatialIndex::GetTree() const
+{
+	return _tree;
+}
+
+void SpatialIndex::OnDestroy(entt::registry& registry, entt::entity entity)
+{
+	CullingComponent& culling = registry.get<CullingComponent>(entity);
+	if (culling.Proxy != AABBTree::NULL_NODE)
+	{
+		_tree.DestroyProxy(culling.Proxy);
+		culling.Proxy = AABBTree::NULL_NODE;
+	}
+}
+
+const CullingComponent& SpatialIndex::GetCulling(uint32_t userData) const
+{
+	return _registry.get<CullingComponent>(static_cast<entt::entity>(userData));
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <functional>
+#include <vector>
+#include <Scene.h>
+
+#include "Graphics/AABBTree.h"
+#include "Graphics/CullingComponent.h"
+
+//Keeps an AABBTree over every entity with a CullingComponent
+//*Entities are added the first time Update sees them and removed when their CullingComponent is destroyed
+//*Queries only return entities whose world bounds actually pass, not just their fat box
+class SpatialIndex
+{
+public:
+	SpatialIndex(entt::registry& registry, float margin = 0.2f);
+	//Stops listening to the registry
+	~SpatialIndex();
+
+	SpatialIndex(const SpatialIndex& other) = delete;
+	SpatialIndex& operator=(const SpatialIndex& other) = delete;
+
+	//Adds or moves the changed entities (see TransformSystem::Flush), only ones that left their fat box touch the tree
+	//*Call after the world bounds have been updated
+	void Update(const std::vector<entt::entity>& changed);
+
+	void QueryFrustum(const Frustum& frustum, const std::function<void(entt::entity)>& callback) const;
+	void QuerySphere(const BoundingSphere& sphere, const std::function<void(entt::entity)>& callback) const;
+	void QueryBox(const AABB& box, const std::function<void(entt::entity)>& callback) const;
+	//Finds the closest entity the ray hits, returns false if it doesn't hit anything
+	bool RayCast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, entt::entity& hit, float& distance) const;
+
+	//Getters
+	const AABBTree& GetTree() const;
+
+private:
+	void OnDestroy(entt::registry& registry, entt::entity entity);
+
+	const CullingComponent& GetCulling(uint32_t userData) const;
+
+	entt::registry& _registry;
+	AABBTree _tree;
+};
@@ -0,0 +1,64 @@
+#include "TransformSystem.h"
+
+#include "Graphics/CullingComponent.h"
+#include "Utilities/JobSystem.h"
+
+TransformSystem::TransformSystem(entt::registry& registry)
+	: _registry(registry)
+{
+	_registry.on_construct<Transform>().connect<&TransformSystem::OnConstruct>(*this);
+	//Bounds added to an entity that already exists need their world bounds worked out
+	_registry.on_construct<CullingComponent>().connect<&TransformSystem::OnConstruct>(*this);
+
+	//Anything that already exists hasn't been through a flush yet
+	_registry.view<Transform>().each([&](entt::entity entity, Transform&) {
+		MarkDirty(entity);
+	});
+}
+
+TransformSystem::~TransformSystem()
+{
+	_registry.on_construct<Transform>().disconnect<&TransformSystem::OnConstruct>(*this);
+	_registry.on_construct<CullingComponent>().disconnect<&TransformSystem::OnConstruct>(*this);
+}
+
+void TransformSystem::MarkDirty(entt::entity entity)
+{
+	_registry.emplace_or_replace<DirtyTransform>(entity);
+}
+
+const std::vector<entt::entity>& TransformSystem::Flush()
+{
+	_updated.clear();
+	_registry.view<DirtyTransform>().each([&](entt::entity entity) {
+		_updated.push_back(entity);
+	});
+
+	//Transforms don't depend on each other, so the list can be split across the workers
+	JobSystem::ParallelFor(_updated.size(), UPDATE_GRAIN_SIZE, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++)
+		{
+			//Only looking up components here, nothing is added or removed until the flush is done
+			Transform* transform = _registry.try_get<Transform>(_updated[i]);
+			if (transform == nullptr)
+				continue;
+
+			transform->UpdateWorldMatrix();
+			if (CullingComponent* culling = _registry.try_get<CullingComponent>(_updated[i]))
+				culling->UpdateWorldBounds(transform->WorldTransform());
+		}
+	});
+
+	_registry.clear<DirtyTransform>();
+	return _updated;
+}
+
+const std::vector<entt::entity>& TransformSystem::GetUpdated() const
+{
+	return _updated;
+}
+
+void TransformSystem::OnConstruct(entt::registry& registry, entt::entity entity)
+{
+	MarkDirty(entity);
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <vector>
+#include <Scene.h>
+#include <Transform.h>
+
+//Tag for transforms that changed since the last flush
+struct DirtyTransform
+{
+};
+
+//Only recomputes the world matrices of transforms that changed
+//*New transforms start dirty, anything that moves one afterwards calls MarkDirty
+class TransformSystem
+{
+public:
+	explicit TransformSystem(entt::registry& registry);
+	//Stops listening to the registry
+	~TransformSystem();
+
+	TransformSystem(const TransformSystem& other) = delete;
+	TransformSystem& operator=(const TransformSystem& other) = delete;
+
+	//Flags a transform to be updated at the next flush
+	void MarkDirty(entt::entity entity);
+
+	//Updates the world matrix and world bounds of every dirty transform
+	//*The dirty list is split across the JobSystem workers
+	//*Returns the entities that were updated
+	const std::vector<entt::entity>& Flush();
+
+	//Getters
+	//Entities updated by the last flush
+	const std::vector<entt::entity>& GetUpdated() const;
+
+private:
+	void OnConstruct(entt::registry& registry, entt::entity entity);
+
+	//Fewest transforms a worker is handed at once, anything less isn't worth the hand off
+	static const size_t UPDATE_GRAIN_SIZE = 64;
+
+	entt::registry& _registry;
+	//Reused every flush so it doesn't allocate once it's big enough
+	std::vector<entt::entity> _updated;
+};
@@ -8,6 +8,21 @@ bool Util::Init()
     return true;
 }
 
+uint64_t Util::HashBytes(const void* data, size_t size, uint64_t seed)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    uint64_t hash = seed;
+
+    //XOR in each byte then multiply by the FNV prime
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+
+    return hash;
+}
+
 bool Util::CheckNumBetween(int num, int min, int max)
 {
     //Is the num greater than the minimum
@@ -2,11 +2,17 @@
 #include <GLM/glm.hpp>
 #include <time.h>
 #include <vector>
+#include <cstdint>
+#include <cstddef>
 
 namespace Util
 {
 	bool Init();
 
+	//Hashes a block of bytes (64 bit FNV-1a)
+	//*Used to key caches on the contents of a file rather than its name
+	uint64_t HashBytes(const void* data, size_t size, uint64_t seed = 14695981039346656037ull);
+
 	//Find templated type in vector
 	template <typename T>
 	static int FindInVector(T toFind, std::vector<T> findIn)
@@ -4,6 +4,7 @@
 #include <filesystem>
 #include <json.hpp>
 #include <fstream>
+#include <climits>
 
 #include <Texture2D.h>
 #include <Texture2DData.h>
@@ -45,76 +46,91 @@ int main() {
 	// Push another scope so most memory should be freed *before* we exit the app
 	{
 		#pragma region Shader and ImGui
-		Shader::sptr passthroughShader = Shader::Create();
-		passthroughShader->LoadShaderPartFromFile("shaders/passthrough_vert.glsl", GL_VERTEX_SHADER);
-		passthroughShader->LoadShaderPartFromFile("shaders/passthrough_frag.glsl", GL_FRAGMENT_SHADER);
-		passthroughShader->Link();
-
-		Shader::sptr colorCorrectionShader = Shader::Create();
-		colorCorrectionShader->LoadShaderPartFromFile("shaders/passthrough_vert.glsl", GL_VERTEX_SHADER);
-		colorCorrectionShader->LoadShaderPartFromFile("shaders/Post/color_correction_frag.glsl", GL_FRAGMENT_SHADER);
-		colorCorrectionShader->Link();
+		Shader::sptr passthroughShader = ShaderLibrary::Load("shaders/passthrough_vert.glsl", "shaders/passthrough_frag.glsl");
 
 		// Load our shaders
-		Shader::sptr shader = Shader::Create();
-		shader->LoadShaderPartFromFile("shaders/vertex_shader.glsl", GL_VERTEX_SHADER);
-		shader->LoadShaderPartFromFile("shaders/frag_phong.glsl", GL_FRAGMENT_SHADER);
-		shader->Link();
-
-		glm::vec3 lightPos = glm::vec3(0.0f, 0.0f, 5.0f);
-		glm::vec3 lightCol = glm::vec3(0.9f, 0.85f, 0.5f);
-		float     lightAmbientPow = 0.05f;
-		float     lightSpecularPow = 1.0f;
-		glm::vec3 ambientCol = glm::vec3(1.0f);
-		float     ambientPow = 0.1f;
-		float     lightLinearFalloff = 0.09f;
-		float     lightQuadraticFalloff = 0.032f;
-		float	  wavy = 1;
+		Shader::sptr shader = ShaderLibrary::Load("shaders/vertex_shader.glsl", "shaders/frag_phong.glsl");
 
 		// These are our application / scene level uniforms that don't necessarily update
-		// every frame
-		shader->SetUniform("u_LightPos", lightPos);
-		shader->SetUniform("u_LightCol", lightCol);
-		shader->SetUniform("u_AmbientLightStrength", lightAmbientPow);
-		shader->SetUniform("u_SpecularLightStrength", lightSpecularPow);
-		shader->SetUniform("u_AmbientCol", ambientCol);
-		shader->SetUniform("u_AmbientStrength", ambientPow);
-		shader->SetUniform("u_LightAttenuationConstant", 1.0f);
-		shader->SetUniform("u_LightAttenuationLinear", lightLinearFalloff);
-		shader->SetUniform("u_LightAttenuationQuadratic", lightQuadraticFalloff);
+		// every frame, every lit shader reads them from the SceneLighting block
+		SceneLighting lighting;
+		//Set whenever lighting changes, it gets uploaded once before the next frame draws
+		bool lightingChanged = true;
+		float	  wavy = 1;
+		//Value isWavy gets next, set once the water program has finished building so it never waits on the link
+		float	  wavyUniform = wavy;
+		bool wavyChanged = true;
 
 		// Load our shaders
-		Shader::sptr shaderWater = Shader::Create();
-		shaderWater->LoadShaderPartFromFile("shaders/vert_water.glsl", GL_VERTEX_SHADER);
-		shaderWater->LoadShaderPartFromFile("shaders/frag_water.glsl", GL_FRAGMENT_SHADER);
-		shaderWater->Link();
-
-		shaderWater->SetUniform("u_LightPos", lightPos);
-		shaderWater->SetUniform("u_LightCol", lightCol);
-		shaderWater->SetUniform("u_AmbientLightStrength", lightAmbientPow);
-		shaderWater->SetUniform("u_SpecularLightStrength", lightSpecularPow);
-		shaderWater->SetUniform("u_AmbientCol", ambientCol);
-		shaderWater->SetUniform("u_AmbientStrength", ambientPow);
-		shaderWater->SetUniform("u_LightAttenuationConstant", 1.0f);
-		shaderWater->SetUniform("u_LightAttenuationLinear", lightLinearFalloff);
-		shaderWater->SetUniform("u_LightAttenuationQuadratic", lightQuadraticFalloff);
-		shaderWater->SetUniform("isWavy", wavy);
-
-		PostEffect* basicEffect;
+		Shader::sptr shaderWater = ShaderLibrary::Load("shaders/vert_water.glsl", "shaders/frag_water.glsl");
 
 		int activeEffect = 0;
 		std::vector<PostEffect*> effects;
+		//Pass index of each effect in the post processing graph
+		std::vector<int> effectPasses;
+		PostProcessGraph* postGraph;
 
 		GreyscaleEffect* greyscaleEffect;
 		SepiaEffect* sepiaEffect;
+
+		//Opaque phong objects get drawn through the G-buffer when this is on
+		bool useDeferred = true;
+		DeferredRenderer* deferred;
+		std::vector<PointLight> pointLights;
+		int pointLightCount = 128;
+		//Point lights for forward shaded objects (anything the deferred path doesn't draw)
+		LightClusters lightClusters;
+		lightClusters.Init();
+
+		//Scatters point lights over the playable area
+		auto generatePointLights = [&]() {
+			pointLights.resize(pointLightCount);
+			for (PointLight& light : pointLights)
+			{
+				light.Position = glm::vec3(Util::GetRandomNumberBetween(-19.0f, 19.0f), Util::GetRandomNumberBetween(-19.0f, 19.0f), Util::GetRandomNumberBetween(0.5f, 3.0f));
+				light.Radius = Util::GetRandomNumberBetween(2.0f, 5.0f);
+				light.Color = glm::vec3(Util::GetRandomNumberBetween(0.2f, 1.0f), Util::GetRandomNumberBetween(0.2f, 1.0f), Util::GetRandomNumberBetween(0.2f, 1.0f));
+				light.Intensity = 1.0f;
+			}
+		};
+		generatePointLights();
 		
 
+		//Skip drawing anything outside the camera
+		bool useCulling = true;
+		int culledCount = 0;
+		int cullableCount = 0;
+		//Name of whatever is in the middle of the screen
+		std::string lookingAt = "Nothing";
+		int transformsUpdated = 0;
+		int renderQueueSorts = 0;
+		//Draw pooled meshes through multi draw indirect
+		bool useIndirect = true;
+		int indirectBatches = 0;
+		int indirectDraws = 0;
+		//Calls that went through GLStateCache last frame
+		int stateCallsIssued = 0;
+		int stateCallsSkipped = 0;
+
 		// We'll add some ImGui controls to control our shader
 		BackendHandler::imGuiCallbacks.push_back([&]() {
 			if (ImGui::CollapsingHeader("Effect Controls"))
 			{
 				ImGui::SliderInt("Chosen Effect", &activeEffect, 0, effects.size() - 1);
 
+				bool enabled = postGraph->IsEnabled(effectPasses[activeEffect]);
+				if (ImGui::Checkbox("Enabled", &enabled))
+				{
+					postGraph->SetEnabled(effectPasses[activeEffect], enabled);
+				}
+
+				bool fuse = postGraph->IsFusing();
+				if (ImGui::Checkbox("Fuse Effects", &fuse))
+				{
+					postGraph->SetFusion(fuse);
+				}
+				ImGui::Text("Fullscreen passes: %d, fused programs: %d", postGraph->GetLastPassCount(), int(postGraph->GetFuser().GetProgramCount()));
+
 				if (activeEffect == 0)
 				{
 					ImGui::Text("Active Effect: Greyscale Effect");
@@ -140,41 +156,89 @@ int main() {
 					}
 				}
 			}
+			if (ImGui::CollapsingHeader("Point Lights"))
+			{
+				ImGui::Checkbox("Deferred Shading", &useDeferred);
+				if (ImGui::SliderInt("Point Lights", &pointLightCount, 0, LightClusters::MAX_LIGHTS))
+				{
+					generatePointLights();
+				}
+				ImGui::Text("Deferred lights on screen: %d", deferred->GetLightsDrawn());
+				ImGui::Text("Cluster light refs: %d, busiest cluster: %u", int(lightClusters.GetIndexCount()), lightClusters.GetMaxClusterLights());
+			}
+			if (ImGui::CollapsingHeader("Frustum Culling"))
+			{
+				ImGui::Checkbox("Cull Off Screen Objects", &useCulling);
+				ImGui::Text("Culled: %d / %d", culledCount, cullableCount);
+				ImGui::Text("Looking at: %s", lookingAt.c_str());
+			}
+			if (ImGui::CollapsingHeader("Transforms"))
+			{
+				ImGui::Text("Transforms updated: %d", transformsUpdated);
+			}
+			if (ImGui::CollapsingHeader("Render Queue"))
+			{
+				ImGui::Text("Render queue sorts: %d", renderQueueSorts);
+			}
+			if (ImGui::CollapsingHeader("Indirect Drawing"))
+			{
+				ImGui::Checkbox("Multi Draw Indirect", &useIndirect);
+				ImGui::Text("Indirect draws: %d in %d batches", indirectDraws, indirectBatches);
+			}
+			if (ImGui::CollapsingHeader("GL State Cache"))
+			{
+				ImGui::Text("GL state calls: %d issued, %d skipped", stateCallsIssued, stateCallsSkipped);
+			}
+			if (ImGui::CollapsingHeader("Shaders"))
+			{
+				ImGui::Text("Shader stages compiled: %d, programs linked: %d, from binary: %d", ShaderLibrary::GetCompileCount(), ShaderLibrary::GetLinkCount(), ShaderLibrary::GetBinaryLoadCount());
+				ImGui::Text("Shader programs building: %d (%s)", ShaderLibrary::GetPendingCount(), ShaderLibrary::IsParallel() ? "parallel" : "serial");
+			}
+			if (ImGui::CollapsingHeader("Texture Streaming"))
+			{
+				ImGui::Text("Textures loading: %d (%.1f KB uploaded)", AsyncTextureLoader::GetPendingCount(), AsyncTextureLoader::GetUploadedBytes() / 1024.0f);
+			}
 			if (ImGui::CollapsingHeader("Environment generation"))
 			{
 				if (ImGui::Button("Regenerate Environment", ImVec2(200.0f, 40.0f)))
 				{
 					EnvironmentGenerator::RegenerateEnvironment();
 				}
+				bool instanced = EnvironmentGenerator::IsInstanced();
+				if (ImGui::Checkbox("Instanced Spawns", &instanced))
+				{
+					EnvironmentGenerator::SetInstanced(instanced);
+					EnvironmentGenerator::RegenerateEnvironment();
+				}
 			}
 			if (ImGui::CollapsingHeader("Scene Level Lighting Settings"))
 			{
-				if (ImGui::ColorPicker3("Ambient Color", glm::value_ptr(ambientCol))) {
-					shader->SetUniform("u_AmbientCol", ambientCol);
+				if (ImGui::ColorPicker3("Ambient Color", glm::value_ptr(lighting.AmbientCol))) {
+					lightingChanged = true;
 				}
-				if (ImGui::SliderFloat("Fixed Ambient Power", &ambientPow, 0.01f, 1.0f)) {
-					shader->SetUniform("u_AmbientStrength", ambientPow);
+				if (ImGui::SliderFloat("Fixed Ambient Power", &lighting.AmbientStrength, 0.01f, 1.0f)) {
+					lightingChanged = true;
 				}
 			}
 			if (ImGui::CollapsingHeader("Light Level Lighting Settings"))
 			{
-				if (ImGui::DragFloat3("Light Pos", glm::value_ptr(lightPos), 0.01f, -10.0f, 10.0f)) {
-					shader->SetUniform("u_LightPos", lightPos);
+				if (ImGui::DragFloat3("Light Pos", glm::value_ptr(lighting.LightPos), 0.01f, -10.0f, 10.0f)) {
+					lightingChanged = true;
 				}
-				if (ImGui::ColorPicker3("Light Col", glm::value_ptr(lightCol))) {
-					shader->SetUniform("u_LightCol", lightCol);
+				if (ImGui::ColorPicker3("Light Col", glm::value_ptr(lighting.LightCol))) {
+					lightingChanged = true;
 				}
-				if (ImGui::SliderFloat("Light Ambient Power", &lightAmbientPow, 0.0f, 1.0f)) {
-					shader->SetUniform("u_AmbientLightStrength", lightAmbientPow);
+				if (ImGui::SliderFloat("Light Ambient Power", &lighting.AmbientLightStrength, 0.0f, 1.0f)) {
+					lightingChanged = true;
 				}
-				if (ImGui::SliderFloat("Light Specular Power", &lightSpecularPow, 0.0f, 1.0f)) {
-					shader->SetUniform("u_SpecularLightStrength", lightSpecularPow);
+				if (ImGui::SliderFloat("Light Specular Power", &lighting.SpecularLightStrength, 0.0f, 1.0f)) {
+					lightingChanged = true;
 				}
-				if (ImGui::DragFloat("Light Linear Falloff", &lightLinearFalloff, 0.01f, 0.0f, 1.0f)) {
-					shader->SetUniform("u_LightAttenuationLinear", lightLinearFalloff);
+				if (ImGui::DragFloat("Light Linear Falloff", &lighting.AttenuationLinear, 0.01f, 0.0f, 1.0f)) {
+					lightingChanged = true;
 				}
-				if (ImGui::DragFloat("Light Quadratic Falloff", &lightQuadraticFalloff, 0.01f, 0.0f, 1.0f)) {
-					shader->SetUniform("u_LightAttenuationQuadratic", lightQuadraticFalloff);
+				if (ImGui::DragFloat("Light Quadratic Falloff", &lighting.AttenuationQuadratic, 0.01f, 0.0f, 1.0f)) {
+					lightingChanged = true;
 				}
 			}
 
@@ -206,28 +270,44 @@ int main() {
 
 		#pragma region TEXTURE LOADING
 		    
+		// Load the cube map
+		// This decodes on the main thread, so it goes before any async loads start (see AsyncTextureLoader)
+		//TextureCubeMap::sptr environmentMap = TextureCubeMap::LoadFromImages("images/cubemaps/skybox/sample.jpg");
+		TextureCubeMap::sptr environmentMap = TextureCubeMap::LoadFromImages("images/cubemaps/skybox/ToonSky.jpg"); 
+		TextureSampling::Apply(environmentMap->GetHandle(), true, 1.0f);
+
+		// The ground and water are mostly seen at grazing angles, so they get the most anisotropy
+		Texture2DDescription groundSampling = TextureSampling::DefaultDescription();
+		groundSampling.MaxAnisotropic = 16.0f;
+
 		// Load some textures from files
-		Texture2D::sptr stone = Texture2D::LoadFromFile("images/Stone_001_Diffuse.png");
-		Texture2D::sptr stoneSpec = Texture2D::LoadFromFile("images/Stone_001_Specular.png");
-		Texture2D::sptr grass = Texture2D::LoadFromFile("images/grass.jpg");
-		Texture2D::sptr noSpec = Texture2D::LoadFromFile("images/grassSpec.png");
-		Texture2D::sptr box = Texture2D::LoadFromFile("images/box.bmp");
-		Texture2D::sptr boxSpec = Texture2D::LoadFromFile("images/box-reflections.bmp");
-		Texture2D::sptr simpleFlora = Texture2D::LoadFromFile("images/SimpleFlora.png");
-
-		LUT3D tempCube("cubes/neutral.cube");
+		// These decode in the background and show as white until they've been uploaded
+		Texture2D::sptr stone = AsyncTextureLoader::LoadFromFile("images/Stone_001_Diffuse.png", groundSampling);
+		Texture2D::sptr stoneSpec = AsyncTextureLoader::LoadFromFile("images/Stone_001_Specular.png");
+		Texture2D::sptr grass = AsyncTextureLoader::LoadFromFile("images/grass.jpg", groundSampling);
+		Texture2D::sptr noSpec = AsyncTextureLoader::LoadFromFile("images/grassSpec.png");
+		Texture2D::sptr box = AsyncTextureLoader::LoadFromFile("images/box.bmp");
+		Texture2D::sptr boxSpec = AsyncTextureLoader::LoadFromFile("images/box-reflections.bmp");
+		Texture2D::sptr simpleFlora = AsyncTextureLoader::LoadFromFile("images/SimpleFlora.png");
+
 		LUT3D warmCube("cubes/warmCorrection.cube");
 		LUT3D coolCube("cubes/coolCorrection.cube");
 		LUT3D customCube("cubes/customCorrection.cube");
 		LUT3D neutralCube("cubes/neutral.cube");
-		
-		Texture2D::sptr volcano = Texture2D::LoadFromFile("images/volcano.png");
-		Texture2D::sptr phoenix = Texture2D::LoadFromFile("images/phoenixTex.png");
-		Texture2D::sptr water = Texture2D::LoadFromFile("images/water.jpg");
 
-		// Load the cube map
-		//TextureCubeMap::sptr environmentMap = TextureCubeMap::LoadFromImages("images/cubemaps/skybox/sample.jpg");
-		TextureCubeMap::sptr environmentMap = TextureCubeMap::LoadFromImages("images/cubemaps/skybox/ToonSky.jpg"); 
+		BackendHandler::imGuiCallbacks.push_back([&]() {
+			if (ImGui::CollapsingHeader("Color Grading Memory"))
+			{
+				ImGui::Text("Warm: %.1f KB", warmCube.getResidentBytes() / 1024.0f);
+				ImGui::Text("Cool: %.1f KB", coolCube.getResidentBytes() / 1024.0f);
+				ImGui::Text("Custom: %.1f KB", customCube.getResidentBytes() / 1024.0f);
+				ImGui::Text("Neutral: %.1f KB", neutralCube.getResidentBytes() / 1024.0f);
+			}
+		});
+		
+		Texture2D::sptr volcano = AsyncTextureLoader::LoadFromFile("images/volcano.png");
+		Texture2D::sptr phoenix = AsyncTextureLoader::LoadFromFile("images/phoenixTex.png");
+		Texture2D::sptr water = AsyncTextureLoader::LoadFromFile("images/water.jpg", groundSampling);
 
 		// Creating an empty texture
 		Texture2DDescription desc = Texture2DDescription();  
@@ -252,9 +332,18 @@ int main() {
 		GameScene::sptr scene = GameScene::Create("test");
 		Application::Instance().ActiveScene = scene;
 
-		// We can create a group ahead of time to make iterating on the group faster
-		entt::basic_group<entt::entity, entt::exclude_t<>, entt::get_t<Transform>, RendererComponent> renderGroup =
-			scene->Registry().group<RendererComponent>(entt::get_t<Transform>());
+		// Bounding volume tree over everything with bounds, for culling and picking
+		SpatialIndex spatialIndex(scene->Registry());
+		// Only transforms that changed get their world matrix recomputed
+		TransformSystem transforms(scene->Registry());
+		// Behaviours picked out each frame to update on the job system
+		std::vector<std::pair<entt::entity, IBehaviour*>> parallelBehaviours;
+
+		// Renderers sorted by layer, shader and material, only re-sorted when they change
+		RenderQueue renderQueue(scene->Registry());
+		// Draws pooled meshes a material at a time with glMultiDrawElementsIndirect
+		IndirectRenderer indirect;
+		indirect.Init(BackendHandler::meshPool, BackendHandler::drawData);
 
 		// Create a material and set some properties for it
 		ShaderMaterial::sptr stoneMat = ShaderMaterial::Create();  
@@ -308,15 +397,17 @@ int main() {
 
 		GameObject obj1 = scene->CreateEntity("Water"); 
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/plane.obj");
-			obj1.emplace<RendererComponent>().SetMesh(vao).SetMaterial(waterMat);
+			MeshData mesh = MeshLoader::LoadFromFile("models/plane.obj");
+			obj1.emplace<RendererComponent>().SetMesh(mesh.Mesh).SetMaterial(waterMat);
+			obj1.emplace<CullingComponent>(mesh.Bounds);
 			obj1.get<Transform>().SetLocalPosition(glm::vec3(0, 0, 1.1));
 		}
 
 		GameObject waterOBJ = scene->CreateEntity("Ground");
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/volcano.obj");
-			waterOBJ.emplace<RendererComponent>().SetMesh(vao).SetMaterial(volcanoMat);
+			MeshData mesh = MeshLoader::LoadFromFile("models/volcano.obj");
+			waterOBJ.emplace<RendererComponent>().SetMesh(mesh.Mesh).SetMaterial(volcanoMat);
+			waterOBJ.emplace<CullingComponent>(mesh.Bounds);
 			waterOBJ.get<Transform>().SetLocalPosition(glm::vec3(0, 0, 0.6));
 			waterOBJ.get<Transform>().SetLocalRotation(glm::vec3(90, 0, 0));
 		}
@@ -324,8 +415,9 @@ int main() {
 
 		GameObject obj2 = scene->CreateEntity("Goblin");
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/goblin.obj");
-			obj2.emplace<RendererComponent>().SetMesh(vao).SetMaterial(stoneMat);
+			MeshData mesh = MeshLoader::LoadFromFile("models/goblin.obj");
+			obj2.emplace<RendererComponent>().SetMesh(mesh.Mesh).SetMaterial(stoneMat);
+			obj2.emplace<CullingComponent>(mesh.Bounds);
 			obj2.get<Transform>().SetLocalPosition(0.0f, -1.5f, 0.0f);
 			obj2.get<Transform>().SetLocalRotation(90.0f, 0.0f, 0.0f);
 			obj2.get<Transform>().SetLocalScale(glm::vec3(0.9));
@@ -334,8 +426,9 @@ int main() {
 
 		GameObject obj3 = scene->CreateEntity("Phoenix");
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/phoenix.obj");
-			obj3.emplace<RendererComponent>().SetMesh(vao).SetMaterial(phoenixMat);
+			MeshData mesh = MeshLoader::LoadFromFile("models/phoenix.obj");
+			obj3.emplace<RendererComponent>().SetMesh(mesh.Mesh).SetMaterial(phoenixMat);
+			obj3.emplace<CullingComponent>(mesh.Bounds);
 			obj3.get<Transform>().SetLocalPosition(0.0f, -5.0f, -10.0f);
 			obj3.get<Transform>().SetLocalRotation(90.0f, 0.0f, 0.0f);
 			obj3.get<Transform>().SetLocalScale(glm::vec3(2.0));
@@ -394,13 +487,36 @@ int main() {
 			colorCorrect->AddDepthTarget();
 			colorCorrect->Init(width, height);
 		}
+
+		GameObject deferredObj = scene->CreateEntity("Deferred Renderer");
+		{
+			deferred = &deferredObj.emplace<DeferredRenderer>();
+			deferred->Init(width, height);
+		}
+		//G-buffer versions of the phong materials, made the first time each one is drawn
+		std::unordered_map<ShaderMaterial*, ShaderMaterial::sptr> deferredMaterials;
+		auto getDeferredMaterial = [&](const ShaderMaterial::sptr& material) {
+			ShaderMaterial::sptr& result = deferredMaterials[material.get()];
+			if (result == nullptr)
+			{
+				result = std::make_shared<ShaderMaterial>(*material);
+				result->Shader = deferred->GetGeometryShader();
+			}
+			return result;
+		};
 		
-		GameObject framebufferObject = scene->CreateEntity("Basic Effect");
+		ColorGradingStage* colorGrading;
+		GameObject colorGradingObj = scene->CreateEntity("Color Grading");
 		{
-			basicEffect = &framebufferObject.emplace<PostEffect>();
-			basicEffect->Init(width, height);
+			colorGrading = &colorGradingObj.emplace<ColorGradingStage>();
+			colorGrading->Init(width, height);
 		}
-
+		int neutralGrade = colorGrading->AddGrade(&neutralCube);
+		int warmGrade = colorGrading->AddGrade(&warmCube);
+		int coolGrade = colorGrading->AddGrade(&coolCube);
+		int customGrade = colorGrading->AddGrade(&customCube);
+		//How long switching between grades takes
+		const float gradeFadeTime = 0.5f;
 		
 		GameObject greyscaleEffectObject = scene->CreateEntity("Greyscale Effect");
 		{
@@ -416,16 +532,23 @@ int main() {
 		}
 		effects.push_back(sepiaEffect);
 
+		GameObject postGraphObject = scene->CreateEntity("Post Processing");
+		{
+			postGraph = &postGraphObject.emplace<PostProcessGraph>();
+			postGraph->Init(width, height);
+		}
+		//Effects start off, grading always runs last
+		effectPasses.push_back(postGraph->AddPass(greyscaleEffect, false));
+		effectPasses.push_back(postGraph->AddPass(sepiaEffect, false));
+		postGraph->AddPass(colorGrading);
+
 		#pragma endregion 
 		//////////////////////////////////////////////////////////////////////////////////////////
 
 		/////////////////////////////////// SKYBOX ///////////////////////////////////////////////
 		{
 			// Load our shaders
-			Shader::sptr skybox = std::make_shared<Shader>();
-			skybox->LoadShaderPartFromFile("shaders/skybox-shader.vert.glsl", GL_VERTEX_SHADER);
-			skybox->LoadShaderPartFromFile("shaders/skybox-shader.frag.glsl", GL_FRAGMENT_SHADER);
-			skybox->Link();
+			Shader::sptr skybox = ShaderLibrary::Load("shaders/skybox-shader.vert.glsl", "shaders/skybox-shader.frag.glsl");
 
 			ShaderMaterial::sptr skyboxMat = ShaderMaterial::Create();
 			skyboxMat->Shader = skybox;  
@@ -482,116 +605,83 @@ int main() {
 				
 				//Lighting
 				if (isLit) {
-					shader->SetUniform("u_LightPos", glm::vec3(0, 0, -1000));
-					shader->SetUniform("u_LightAttenuationLinear", float(0.019));
-					shader->SetUniform("u_LightAttenuationQuadratic", float(0.5));
-					shaderWater->SetUniform("u_LightPos", glm::vec3(0, 0, -1000));
-					shaderWater->SetUniform("u_LightAttenuationLinear", float(0.019));
-					shaderWater->SetUniform("u_LightAttenuationQuadratic", float(0.5));
+					lighting.LightPos = glm::vec3(0, 0, -1000);
+					lighting.AttenuationLinear = 0.019f;
+					lighting.AttenuationQuadratic = 0.5f;
 					isLit = false;
 				}
 				else {
-					shader->SetUniform("u_LightPos", glm::vec3(0, 0, 10));
-					shader->SetUniform("u_LightAttenuationLinear", float(0.0));
-					shader->SetUniform("u_LightAttenuationQuadratic", float(0.0));
-					shaderWater->SetUniform("u_LightPos", glm::vec3(0, 0, 10));
-					shaderWater->SetUniform("u_LightAttenuationLinear", float(0.0));
-					shaderWater->SetUniform("u_LightAttenuationQuadratic", float(0.0));
+					lighting.LightPos = glm::vec3(0, 0, 10);
+					lighting.AttenuationLinear = 0.0f;
+					lighting.AttenuationQuadratic = 0.0f;
 					isLit = true;
 				}
+				lightingChanged = true;
 			});
 
 			keyToggles.emplace_back(GLFW_KEY_2, [&]() {
 
 				//Ambient lighting only
-				if (lightAmbientPow > 0) {
-					lightAmbientPow = 0;
-					lightSpecularPow = 0;
-					shader->SetUniform("u_AmbientLightStrength", lightAmbientPow);
-					shader->SetUniform("u_SpecularLightStrength", lightSpecularPow);
-					shaderWater->SetUniform("u_AmbientLightStrength", lightAmbientPow);
-					shaderWater->SetUniform("u_SpecularLightStrength", lightSpecularPow);
+				if (lighting.AmbientLightStrength > 0) {
+					lighting.AmbientLightStrength = 0;
+					lighting.SpecularLightStrength = 0;
 				}
 				else {
-					lightAmbientPow = 1;
-					lightSpecularPow = 0;
-					shader->SetUniform("u_AmbientLightStrength", lightAmbientPow);
-					shader->SetUniform("u_SpecularLightStrength", lightSpecularPow);
-					shaderWater->SetUniform("u_AmbientLightStrength", lightAmbientPow);
-					shaderWater->SetUniform("u_SpecularLightStrength", lightSpecularPow);
+					lighting.AmbientLightStrength = 1;
+					lighting.SpecularLightStrength = 0;
 				}
+				lightingChanged = true;
 			});
 
 			keyToggles.emplace_back(GLFW_KEY_3, [&]() {
 
 				//Specular lighting only
-				if (lightSpecularPow > 0) {
-					lightAmbientPow = 0;
-					lightSpecularPow = 0;
-					shader->SetUniform("u_AmbientLightStrength", lightAmbientPow);
-					shader->SetUniform("u_SpecularLightStrength", lightSpecularPow);
-					shaderWater->SetUniform("u_AmbientLightStrength", lightAmbientPow);
-					shaderWater->SetUniform("u_SpecularLightStrength", lightSpecularPow);
+				if (lighting.SpecularLightStrength > 0) {
+					lighting.AmbientLightStrength = 0;
+					lighting.SpecularLightStrength = 0;
 				}
 				else {
-					lightAmbientPow = 0;
-					lightSpecularPow = 1;
-					shader->SetUniform("u_AmbientLightStrength", lightAmbientPow);
-					shader->SetUniform("u_SpecularLightStrength", lightSpecularPow);
-					shaderWater->SetUniform("u_AmbientLightStrength", lightAmbientPow);
-					shaderWater->SetUniform("u_SpecularLightStrength", lightSpecularPow);
+					lighting.AmbientLightStrength = 0;
+					lighting.SpecularLightStrength = 1;
 				}
+				lightingChanged = true;
 			});
 			  
 			keyToggles.emplace_back(GLFW_KEY_4, [&]() {
 
 				//Ambient + Specular lighting
-				if (lightSpecularPow > 0) {
-					lightAmbientPow = 0;
-					lightSpecularPow = 0;
-					shader->SetUniform("u_AmbientLightStrength", lightAmbientPow);
-					shader->SetUniform("u_SpecularLightStrength", lightSpecularPow);
-					shaderWater->SetUniform("u_AmbientLightStrength", lightAmbientPow);
-					shaderWater->SetUniform("u_SpecularLightStrength", lightSpecularPow);
+				if (lighting.SpecularLightStrength > 0) {
+					lighting.AmbientLightStrength = 0;
+					lighting.SpecularLightStrength = 0;
 				}
 				else {
-					lightAmbientPow = 1;
-					lightSpecularPow = 1;
-					shader->SetUniform("u_AmbientLightStrength", lightAmbientPow);
-					shader->SetUniform("u_SpecularLightStrength", lightSpecularPow);
-					shaderWater->SetUniform("u_AmbientLightStrength", lightAmbientPow);
-					shaderWater->SetUniform("u_SpecularLightStrength", lightSpecularPow);
+					lighting.AmbientLightStrength = 1;
+					lighting.SpecularLightStrength = 1;
 				}
+				lightingChanged = true;
 			});
 
 			keyToggles.emplace_back(GLFW_KEY_5, [&]() {
 
 				//Ambient + Specular lighting + wavy effect
+				wavyUniform = wavy;
+				wavyChanged = true;
 				if (wavy == 1) {
-					shaderWater->SetUniform("isWavy", wavy);
 					wavy = 0;
 				}
 				else {
-					shaderWater->SetUniform("isWavy", wavy);
 					wavy = 1;
 				}
 
-				if (lightSpecularPow > 0) {
-					lightAmbientPow = 0;
-					lightSpecularPow = 0;
-					shader->SetUniform("u_AmbientLightStrength", lightAmbientPow);
-					shader->SetUniform("u_SpecularLightStrength", lightSpecularPow);
-					shaderWater->SetUniform("u_AmbientLightStrength", lightAmbientPow);
-					shaderWater->SetUniform("u_SpecularLightStrength", lightSpecularPow);
+				if (lighting.SpecularLightStrength > 0) {
+					lighting.AmbientLightStrength = 0;
+					lighting.SpecularLightStrength = 0;
 				}
 				else {
-					lightAmbientPow = 1;
-					lightSpecularPow = 1;
-					shader->SetUniform("u_AmbientLightStrength", lightAmbientPow);
-					shader->SetUniform("u_SpecularLightStrength", lightSpecularPow);
-					shaderWater->SetUniform("u_AmbientLightStrength", lightAmbientPow);
-					shaderWater->SetUniform("u_SpecularLightStrength", lightSpecularPow);
+					lighting.AmbientLightStrength = 1;
+					lighting.SpecularLightStrength = 1;
 				}
+				lightingChanged = true;
 			});
 
 			keyToggles.emplace_back(GLFW_KEY_6, [&]() {
@@ -610,9 +700,9 @@ int main() {
 
 				//Color grading warm
 				if (isNeutralCol == true)
-					tempCube = warmCube;
+					colorGrading->CrossFadeTo(warmGrade, gradeFadeTime);
 				else
-					tempCube = neutralCube;
+					colorGrading->CrossFadeTo(neutralGrade, gradeFadeTime);
 
 				isNeutralCol = !isNeutralCol;
 
@@ -622,9 +712,9 @@ int main() {
 
 				//Color grading cool
 				if (isNeutralCol == true)
-					tempCube = coolCube;
+					colorGrading->CrossFadeTo(coolGrade, gradeFadeTime);
 				else
-					tempCube = neutralCube;
+					colorGrading->CrossFadeTo(neutralGrade, gradeFadeTime);
 
 				isNeutralCol = !isNeutralCol;
 
@@ -634,9 +724,9 @@ int main() {
 
 				//Color grading Custom
 				if (isNeutralCol == true)
-					tempCube = customCube;
+					colorGrading->CrossFadeTo(customGrade, gradeFadeTime);
 				else
-					tempCube = neutralCube;
+					colorGrading->CrossFadeTo(neutralGrade, gradeFadeTime);
 
 				isNeutralCol = !isNeutralCol;
 
@@ -659,6 +749,13 @@ int main() {
 
 			time.DeltaTime = time.DeltaTime > 1.0f ? 1.0f : time.DeltaTime;
 
+			//Reallocate render targets once the window has stopped resizing
+			BackendHandler::UpdateDeferredResizes();
+			//Upload any textures that finished decoding
+			AsyncTextureLoader::Update();
+			//Pick up shader programs the driver has finished building
+			ShaderLibrary::Update();
+
 			// Update our FPS tracker data
 			fpsBuffer[frameIx] = 1.0f / time.DeltaTime;
 			frameIx++;
@@ -666,6 +763,7 @@ int main() {
 				frameIx = 0;
 
 			obj2.get<Transform>().SetLocalRotation(obj2.get<Transform>().GetLocalRotation().x, obj2.get<Transform>().GetLocalRotation().y, obj2.get<Transform>().GetLocalRotation().z + 0.1);
+			transforms.MarkDirty(obj2.entity());
 			
 
 			// We'll make sure our UI isn't focused before we start handling input for our game
@@ -679,109 +777,235 @@ int main() {
 			}
 
 			// Iterate over all the behaviour binding components
+			// Behaviours that only move their own transform (like following a path) run across the job system,
+			// anything reading input or the camera stays on the main thread since GLFW only allows that there
+			parallelBehaviours.clear();
 			scene->Registry().view<BehaviourBinding>().each([&](entt::entity entity, BehaviourBinding& binding) {
 				// Iterate over all the behaviour scripts attached to the entity, and update them in sequence (if enabled)
+				bool updated = false;
 				for (const auto& behaviour : binding.Behaviours) {
 					if (behaviour->Enabled) {
-						behaviour->Update(entt::handle(scene->Registry(), entity));
+						if (dynamic_cast<FollowPathBehaviour*>(behaviour.get()) == nullptr)
+							behaviour->Update(entt::handle(scene->Registry(), entity));
+						else
+							parallelBehaviours.push_back({ entity, behaviour.get() });
+						updated = true;
 					}
 				}
+				// Behaviours are what move things, so anything running one might have moved
+				// Marking dirty adds a component, so it has to happen here rather than on a worker
+				if (updated)
+					transforms.MarkDirty(entity);
+			});
+			JobSystem::ParallelFor(parallelBehaviours.size(), 16, [&](size_t begin, size_t end) {
+				for (size_t i = begin; i < end; i++)
+					parallelBehaviours[i].second->Update(entt::handle(scene->Registry(), parallelBehaviours[i].first));
 			});
 
 			// Clear the screen
-			basicEffect->Clear();
+			//Only the scene target needs clearing, post passes overwrite all of their targets
 			colorCorrect->Clear();
-			/*greyscaleEffect->Clear();
-			sepiaEffect->Clear();*/
-			for (int i = 0; i < effects.size(); i++)
-			{
-				effects[i]->Clear();
-			}
 
 			glClearColor(0.08f, 0.17f, 0.31f, 1.0f);
-			glEnable(GL_DEPTH_TEST);
+			GLStateCache::SetEnabled(GL_DEPTH_TEST, true);
 			glClearDepth(1.0f);
 			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-			// Update all world matrices for this frame
-			scene->Registry().view<Transform>().each([](entt::entity entity, Transform& t) {
-				t.UpdateWorldMatrix();
-			});
+			// Update the world matrices (and bounds) of whatever moved this frame
+			const std::vector<entt::entity>& moved = transforms.Flush();
+			transformsUpdated = int(moved.size());
+			// Only entities that moved out of their fat box touch the tree
+			spatialIndex.Update(moved);
 			
 			// Grab out camera info from the camera object
 			Transform& camTransform = cameraObject.get<Transform>();
 			glm::mat4 view = glm::inverse(camTransform.LocalTransform());
 			glm::mat4 projection = cameraObject.get<Camera>().GetProjection();
 			glm::mat4 viewProjection = projection * view;
+
+			// Work out what's on screen before anything gets drawn
+			Frustum frustum(viewProjection);
+			cullableCount = 0;
+			scene->Registry().view<CullingComponent>().each([&](CullingComponent& culling) {
+				culling.Visible = !useCulling;
+				cullableCount++;
+			});
+			culledCount = 0;
+			if (useCulling) {
+				// Whole branches of the tree off screen get skipped at once
+				int visibleCount = 0;
+				spatialIndex.QueryFrustum(frustum, [&](entt::entity e) {
+					scene->Registry().get<CullingComponent>(e).Visible = true;
+					visibleCount++;
+				});
+				culledCount = cullableCount - visibleCount;
+			}
+
+			// Pick whatever is in the middle of the screen
+			entt::entity picked;
+			float pickedDistance;
+			glm::vec3 camForward = -glm::normalize(glm::vec3(camTransform.LocalTransform()[2]));
+			glm::vec3 camPosition = glm::vec3(camTransform.LocalTransform()[3]);
+			if (spatialIndex.RayCast(camPosition, camForward, 100.0f, picked, pickedDistance))
+				lookingAt = scene->Registry().get<GameObjectTag>(picked).Name;
+			else
+				lookingAt = "Nothing";
+			auto isCulled = [&](entt::entity e) {
+				CullingComponent* culling = scene->Registry().try_get<CullingComponent>(e);
+				return culling != nullptr && !culling->Visible;
+			};
+
+			//Sort the point lights into clusters for the forward shaders
+			lightClusters.Update(pointLights, view, projection, colorCorrect->GetRenderWidth(), colorCorrect->GetRenderHeight());
+			lightClusters.Bind();
 						
 			// Sort the renderers by shader and material, we will go for a minimizing context switches approach here,
 			// but you could for instance sort front to back to optimize for fill rate if you have intensive fragment shaders
-			renderGroup.sort<RendererComponent>([](const RendererComponent& l, const RendererComponent& r) {
-				// Sort by render layer first, higher numbers get drawn last
-				if (l.Material->RenderLayer < r.Material->RenderLayer) return true;
-				if (l.Material->RenderLayer > r.Material->RenderLayer) return false;
-
-				// Sort by shader pointer next (so materials using the same shader run sequentially where possible)
-				if (l.Material->Shader < r.Material->Shader) return true;
-				if (l.Material->Shader > r.Material->Shader) return false;
-
-				// Sort by material pointer last (so we can minimize switching between materials)
-				if (l.Material < r.Material) return true;
-				if (l.Material > r.Material) return false;
-				
-				return false;
-			});
+			// Nothing is re-sorted unless renderers were added, removed or changed material
+			const std::vector<RenderItem>& renderItems = renderQueue.Update(camPosition);
+			renderQueueSorts = int(renderQueue.GetSortCount());
 
 			// Start by assuming no shader or material is applied
 			Shader::sptr current = nullptr;
 			ShaderMaterial::sptr currentMat = nullptr;
 
-			waterMat->Set("time", waveTime);
+			//Camera and time go to every shader through one upload
+			BackendHandler::UpdateFrameData(view, projection, waveTime);
+			//Per object matrices get written into this frame's part of the draw data buffer
+			BackendHandler::drawData.BeginFrame();
+			indirectBatches = 0;
+			indirectDraws = 0;
 			waveTime += 0.1;
+			if (lightingChanged) {
+				BackendHandler::UpdateSceneLighting(lighting);
+				lightingChanged = false;
+			}
+			if (wavyChanged && ShaderLibrary::IsReady(shaderWater)) {
+				shaderWater->SetUniform("isWavy", wavyUniform);
+				wavyChanged = false;
+			}
+			//Phong objects are drawn forward until every deferred program has finished building
+			bool deferredThisFrame = useDeferred && deferred->IsReady();
 			   
-			//basicEffect->BindBuffer(0);
-			colorCorrect->Bind();
+			if (deferredThisFrame)
+			{
+				//Opaque phong objects go into the G-buffer
+				deferred->BeginGeometryPass();
+				const Shader::sptr& geometryShader = deferred->GetGeometryShader();
+				GLStateCache::UseProgram(geometryShader);
+				auto applyDeferredMaterial = [&](const ShaderMaterial::sptr& forwardMaterial) {
+					ShaderMaterial::sptr material = getDeferredMaterial(forwardMaterial);
+					if (currentMat != material) {
+						currentMat = material;
+						currentMat->Apply();
+						// Apply binds the material's textures without the state cache knowing
+						GLStateCache::InvalidateTextures();
+					}
+				};
+				// Pooled meshes get batched up and drawn at End, everything else draws straight away
+				indirect.Begin(applyDeferredMaterial);
+				for (const RenderItem& item : renderItems) {
+					RendererComponent& renderer = scene->Registry().get<RendererComponent>(item.Entity);
+					if (renderer.Material->Shader != shader || isCulled(item.Entity))
+						continue;
+
+					const Transform& transform = scene->Registry().get<Transform>(item.Entity);
+					if (useIndirect && indirect.Add(renderer.Material, renderer.Mesh, viewProjection, transform))
+						continue;
+
+					indirect.PrepareDirectDraw();
+					applyDeferredMaterial(renderer.Material);
+					BackendHandler::RenderVAO(renderer.Mesh, viewProjection, transform);
+				}
+				indirect.End();
+				indirectBatches += int(indirect.GetBatchCount());
+				indirectDraws += int(indirect.GetCommandCount());
+				scene->Registry().view<InstancedRenderer>().each([&](entt::entity e, InstancedRenderer& instances) {
+					if (instances.Material->Shader != shader || isCulled(e))
+						return;
+
+					applyDeferredMaterial(instances.Material);
+					instances.Render(geometryShader);
+				});
+				deferred->EndGeometryPass();
+				currentMat = nullptr;
+
+				//Same scene light as frag_phong, plus all the point lights
+				deferred->LightingPass(pointLights, view, projection, colorCorrect);
+			}
 
-			// Iterate over the render group components and draw them
-			renderGroup.each( [&](entt::entity e, RendererComponent& renderer, Transform& transform) {
-				// If the shader has changed, set up it's uniforms
-				if (current != renderer.Material->Shader) {
-					current = renderer.Material->Shader;
-					current->Bind();
-					BackendHandler::SetupShaderForFrame(current, view, projection);
-				}  
+			colorCorrect->Bind();
+			//Render to the part of the target that matches the window
+			colorCorrect->SetViewport();
+
+			auto applyMaterial = [&](const ShaderMaterial::sptr& material) {
+				// If the shader has changed, bind it (per frame uniforms come from the FrameData block)
+				if (current != material->Shader) {
+					current = material->Shader;
+					GLStateCache::UseProgram(current);
+					if (current == shader || current == shaderWater)
+						lightClusters.ApplyUniforms(current);
+				}
 				// If the material has changed, apply it
-				if (currentMat != renderer.Material) {
-					currentMat = renderer.Material;
+				if (currentMat != material) {
+					currentMat = material;
 					currentMat->Apply();
+					// Apply binds the material's textures without the state cache knowing
+					GLStateCache::InvalidateTextures();
 				}
-				// Render the mesh
-				BackendHandler::RenderVAO(renderer.Material->Shader, renderer.Mesh, viewProjection, transform);
-			});
-
-			//basicEffect->UnbindBuffer();
-			colorCorrect->Unbind();
+			};
 
-			colorCorrectionShader->Bind();
-			
-			colorCorrect->BindColorAsTexture(0, 0);
+			// Iterate over the render group components and draw them
+			indirect.Begin(applyMaterial);
+			int currentLayer = INT_MIN;
+			for (const RenderItem& item : renderItems) {
+				RendererComponent& renderer = scene->Registry().get<RendererComponent>(item.Entity);
+				//Already lit by the deferred pass, only water and the skybox are left
+				//Materials whose program is still building are skipped until it's done
+				if ((deferredThisFrame && renderer.Material->Shader == shader) || !ShaderLibrary::IsReady(renderer.Material->Shader) || isCulled(item.Entity))
+					continue;
+
+				// Batched draws from the layer before have to land before this layer draws
+				if (currentLayer != renderer.Material->RenderLayer) {
+					currentLayer = renderer.Material->RenderLayer;
+					indirect.Flush();
+				}
 
-			tempCube.bind(30);
+				// Pooled meshes with the same material go out in one multi draw
+				const Transform& transform = scene->Registry().get<Transform>(item.Entity);
+				if (useIndirect && indirect.Add(renderer.Material, renderer.Mesh, viewProjection, transform))
+					continue;
 
-			colorCorrect->DrawFullscreenQuad();
+				// Queued batches have to go out before this draw's push could move the draw data to a new region
+				indirect.PrepareDirectDraw();
+				applyMaterial(renderer.Material);
+				// Render the mesh
+				BackendHandler::RenderVAO(renderer.Mesh, viewProjection, transform);
+			}
+			indirect.End();
+			indirectBatches += int(indirect.GetBatchCount());
+			indirectDraws += int(indirect.GetCommandCount());
 
-			tempCube.unbind();
-			colorCorrect->UnbindTexture(0);
+			// Instanced spawns draw every copy in one call
+			scene->Registry().view<InstancedRenderer>().each([&](entt::entity e, InstancedRenderer& instances) {
+				if ((deferredThisFrame && instances.Material->Shader == shader) || !ShaderLibrary::IsReady(instances.Material->Shader) || isCulled(e))
+					return;
 
-			colorCorrectionShader->UnBind();
+				applyMaterial(instances.Material);
+				instances.Render(current);
+			});
 
-			//greyscaleEffect->ApplyEffect(basicEffect);
-			//effects[activeEffect]->ApplyEffect(basicEffect);
+			colorCorrect->Unbind();
+			BackendHandler::drawData.EndFrame();
 
-			//greyscaleEffect->DrawToScreen();
-			//effects[activeEffect]->DrawToScreen();
+			colorGrading->Update(time.DeltaTime);
+			//Runs the enabled effects, then grades to the screen
+			postGraph->Execute(colorCorrect);
 
-			//basicEffect->DrawToScreen();
+			// Counted before ImGui, which draws without the state cache
+			stateCallsIssued = int(GLStateCache::GetIssuedCount());
+			stateCallsSkipped = int(GLStateCache::GetSkippedCount());
+			GLStateCache::ResetCounters();
 
 			// Draw our ImGui content
 			BackendHandler::RenderImGui();
@@ -796,8 +1020,13 @@ int main() {
 		//Clean up the environment generator so we can release references
 		EnvironmentGenerator::CleanUpPointers();
 		BackendHandler::ShutdownImGui();
+		ShaderLibrary::Clear();
 	}	
 
+	// Stop the job system workers before anything they could be using goes away
+	JobSystem::Shutdown();
+	AsyncTextureLoader::Unload();
+
 	// Clean up the toolkit logger so we don't leak memory
 	Logger::Uninitialize();
 	return 0;
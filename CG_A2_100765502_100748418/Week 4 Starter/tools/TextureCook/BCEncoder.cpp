@@ -0,0 +1,180 @@
+#include "BCEncoder.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+	//Packs an RGB colour (0-255) into 5:6:5
+	uint16_t PackRGB565(const float* color)
+	{
+		int r = std::clamp(int(std::lround(color[0] * 31.0f / 255.0f)), 0, 31);
+		int g = std::clamp(int(std::lround(color[1] * 63.0f / 255.0f)), 0, 63);
+		int b = std::clamp(int(std::lround(color[2] * 31.0f / 255.0f)), 0, 31);
+		return uint16_t((r << 11) | (g << 5) | b);
+	}
+
+	//Expands 5:6:5 back to 0-255 the way the hardware does
+	void UnpackRGB565(uint16_t packed, float* color)
+	{
+		int r = (packed >> 11) & 31;
+		int g = (packed >> 5) & 63;
+		int b = packed & 31;
+		color[0] = float((r << 3) | (r >> 2));
+		color[1] = float((g << 2) | (g >> 4));
+		color[2] = float((b << 3) | (b >> 2));
+	}
+
+	float DistanceSquared(const float* a, const float* b)
+	{
+		float x = a[0] - b[0], y = a[1] - b[1], z = a[2] - b[2];
+		return x * x + y * y + z * z;
+	}
+
+	void WriteUInt16(uint8_t* out, uint16_t value)
+	{
+		out[0] = uint8_t(value & 0xFF);
+		out[1] = uint8_t(value >> 8);
+	}
+}
+
+void BCEncoder::EncodeBC1(const uint8_t* pixels, uint8_t* block)
+{
+	float colors[16][3];
+	float mean[3] = { 0.0f, 0.0f, 0.0f };
+	for (int i = 0; i < 16; i++)
+	{
+		for (int c = 0; c < 3; c++)
+		{
+			colors[i][c] = pixels[i * 4 + c];
+			mean[c] += colors[i][c] / 16.0f;
+		}
+	}
+
+	//Main axis of the colours (power iteration on the covariance)
+	float covariance[6] = {};
+	for (int i = 0; i < 16; i++)
+	{
+		float r = colors[i][0] - mean[0], g = colors[i][1] - mean[1], b = colors[i][2] - mean[2];
+		covariance[0] += r * r; covariance[1] += r * g; covariance[2] += r * b;
+		covariance[3] += g * g; covariance[4] += g * b; covariance[5] += b * b;
+	}
+	float axis[3] = { 1.0f, 1.0f, 1.0f };
+	for (int iteration = 0; iteration < 8; iteration++)
+	{
+		float x = covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2];
+		float y = covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2];
+		float z = covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2];
+		float length = std::max(std::max(std::fabs(x), std::fabs(y)), std::fabs(z));
+		if (length < 1e-6f)
+			break;
+		axis[0] = x / length; axis[1] = y / length; axis[2] = z / length;
+	}
+
+	//Endpoints are the colours furthest along the axis each way
+	int minIndex = 0, maxIndex = 0;
+	float minDot = FLT_MAX, maxDot = -FLT_MAX;
+	for (int i = 0; i < 16; i++)
+	{
+		float dot = (colors[i][0] - mean[0]) * axis[0] + (colors[i][1] - mean[1]) * axis[1] + (colors[i][2] - mean[2]) * axis[2];
+		if (dot < minDot) { minDot = dot; minIndex = i; }
+		if (dot > maxDot) { maxDot = dot; maxIndex = i; }
+	}
+
+	uint16_t color0 = PackRGB565(colors[maxIndex]);
+	uint16_t color1 = PackRGB565(colors[minIndex]);
+	//color0 > color1 picks the 4 colour mode
+	if (color0 < color1)
+		std::swap(color0, color1);
+
+	uint32_t indices = 0;
+	if (color0 != color1)
+	{
+		float palette[4][3];
+		UnpackRGB565(color0, palette[0]);
+		UnpackRGB565(color1, palette[1]);
+		for (int c = 0; c < 3; c++)
+		{
+			palette[2][c] = (2.0f * palette[0][c] + palette[1][c]) / 3.0f;
+			palette[3][c] = (palette[0][c] + 2.0f * palette[1][c]) / 3.0f;
+		}
+
+		for (int i = 0; i < 16; i++)
+		{
+			int best = 0;
+			float bestDistance = DistanceSquared(colors[i], palette[0]);
+			for (int p = 1; p < 4; p++)
+			{
+				float distance = DistanceSquared(colors[i], palette[p]);
+				if (distance < bestDistance)
+				{
+					bestDistance = distance;
+					best = p;
+				}
+			}
+			indices |= uint32_t(best) << (i * 2);
+		}
+	}
+
+	WriteUInt16(block, color0);
+	WriteUInt16(block + 2, color1);
+	memcpy(block + 4, &indices, sizeof(uint32_t));
+}
+
+void BCEncoder::EncodeBC3(const uint8_t* pixels, uint8_t* block)
+{
+	EncodeBC4(pixels, 3, block);
+	EncodeBC1(pixels, block + 8);
+}
+
+void BCEncoder::EncodeBC4(const uint8_t* pixels, int channel, uint8_t* block)
+{
+	uint8_t minValue = 255, maxValue = 0;
+	for (int i = 0; i < 16; i++)
+	{
+		minValue = std::min(minValue, pixels[i * 4 + channel]);
+		maxValue = std::max(maxValue, pixels[i * 4 + channel]);
+	}
+
+	//value0 > value1 picks the 8 value mode, which spreads 6 steps between them
+	uint8_t value0 = maxValue, value1 = minValue;
+	float palette[8];
+	palette[0] = value0;
+	palette[1] = value1;
+	for (int p = 1; p < 7; p++)
+		palette[p + 1] = ((7 - p) * float(value0) + p * float(value1)) / 7.0f;
+
+	uint64_t indices = 0;
+	if (value0 != value1)
+	{
+		for (int i = 0; i < 16; i++)
+		{
+			float value = pixels[i * 4 + channel];
+			int best = 0;
+			float bestDistance = std::fabs(value - palette[0]);
+			for (int p = 1; p < 8; p++)
+			{
+				float distance = std::fabs(value - palette[p]);
+				if (distance < bestDistance)
+				{
+					bestDistance = distance;
+					best = p;
+				}
+			}
+			indices |= uint64_t(best) << (i * 3);
+		}
+	}
+
+	block[0] = value0;
+	block[1] = value1;
+	for (int i = 0; i < 6; i++)
+		block[2 + i] = uint8_t(indices >> (i * 8));
+}
+
+void BCEncoder::EncodeBC5(const uint8_t* pixels, uint8_t* block)
+{
+	EncodeBC4(pixels, 0, block);
+	EncodeBC4(pixels, 1, block + 8);
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include <cstdint>
+
+//Encodes 4x4 blocks of pixels into the BC formats
+//*pixels is always 16 RGBA8 texels, row by row
+//*Endpoints are fit along the block's main colour axis, good enough for offline cooking without being slow
+class BCEncoder abstract
+{
+public:
+	//8 bytes, RGB only, always uses the 4 colour mode
+	static void EncodeBC1(const uint8_t* pixels, uint8_t* block);
+	//16 bytes, BC4 alpha followed by BC1 colour
+	static void EncodeBC3(const uint8_t* pixels, uint8_t* block);
+	//8 bytes, one channel (0 = red, 3 = alpha)
+	static void EncodeBC4(const uint8_t* pixels, int channel, uint8_t* block);
+	//16 bytes, red then green as two BC4 blocks
+	static void EncodeBC5(const uint8_t* pixels, uint8_t* block);
+};
@@ -0,0 +1,212 @@
+//Cooks images into block compressed DDS files with a full mip chain, so the game can upload them as they are
+//*Usage: TextureCook <image> [more images...] [--format bc1|bc3|bc4|bc5] [--spec] [--normal] [--out <folder>]
+//*By default opaque images become BC1 and images with any transparency become BC3
+//*--spec makes single channel BC4 (the shaders only read .x of specular maps), --normal makes two channel BC5
+//*Output goes to cooked/<name>.<ext>.dds next to each image, which is where AsyncTextureLoader looks for it
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "BCEncoder.h"
+#include "../../src/Utilities/DDSFormat.h"
+
+namespace
+{
+	//One mip level, RGBA8
+	struct Image
+	{
+		int Width = 0;
+		int Height = 0;
+		std::vector<uint8_t> Pixels;
+	};
+
+	//Halves an image with a box filter, odd edges repeat their last texel
+	Image Downsample(const Image& source)
+	{
+		Image result;
+		result.Width = std::max(1, source.Width / 2);
+		result.Height = std::max(1, source.Height / 2);
+		result.Pixels.resize(size_t(result.Width) * result.Height * 4);
+
+		for (int y = 0; y < result.Height; y++)
+		{
+			for (int x = 0; x < result.Width; x++)
+			{
+				int x0 = std::min(x * 2, source.Width - 1), x1 = std::min(x * 2 + 1, source.Width - 1);
+				int y0 = std::min(y * 2, source.Height - 1), y1 = std::min(y * 2 + 1, source.Height - 1);
+				for (int c = 0; c < 4; c++)
+				{
+					int sum = source.Pixels[(size_t(y0) * source.Width + x0) * 4 + c] + source.Pixels[(size_t(y0) * source.Width + x1) * 4 + c] +
+						source.Pixels[(size_t(y1) * source.Width + x0) * 4 + c] + source.Pixels[(size_t(y1) * source.Width + x1) * 4 + c];
+					result.Pixels[(size_t(y) * result.Width + x) * 4 + c] = uint8_t((sum + 2) / 4);
+				}
+			}
+		}
+		return result;
+	}
+
+	//Compresses one mip level block by block, appending to output
+	void CompressLevel(const Image& image, uint32_t format, std::vector<uint8_t>& output)
+	{
+		uint32_t blockBytes = DDSBlockBytes(format);
+		uint8_t texels[16 * 4];
+		uint8_t block[16];
+
+		for (int by = 0; by < image.Height; by += 4)
+		{
+			for (int bx = 0; bx < image.Width; bx += 4)
+			{
+				//Blocks hanging off the edge repeat the edge texels
+				for (int y = 0; y < 4; y++)
+				{
+					for (int x = 0; x < 4; x++)
+					{
+						int sx = std::min(bx + x, image.Width - 1);
+						int sy = std::min(by + y, image.Height - 1);
+						memcpy(texels + (y * 4 + x) * 4, &image.Pixels[(size_t(sy) * image.Width + sx) * 4], 4);
+					}
+				}
+
+				switch (format)
+				{
+				case DXGI_FORMAT_BC1_UNORM: BCEncoder::EncodeBC1(texels, block); break;
+				case DXGI_FORMAT_BC3_UNORM: BCEncoder::EncodeBC3(texels, block); break;
+				case DXGI_FORMAT_BC4_UNORM: BCEncoder::EncodeBC4(texels, 0, block); break;
+				case DXGI_FORMAT_BC5_UNORM: BCEncoder::EncodeBC5(texels, block); break;
+				}
+				output.insert(output.end(), block, block + blockBytes);
+			}
+		}
+	}
+
+	bool HasTransparency(const Image& image)
+	{
+		for (size_t i = 3; i < image.Pixels.size(); i += 4)
+		{
+			if (image.Pixels[i] != 255)
+				return true;
+		}
+		return false;
+	}
+
+	//Cooks one image, returns false if it couldn't be read or written
+	bool Cook(const std::string& input, const std::string& outputFolder, uint32_t format)
+	{
+		Image image;
+		int channels = 0;
+		//Flipped like Texture2D::LoadFromFile, so the cooked texture is the same way up
+		stbi_set_flip_vertically_on_load(true);
+		uint8_t* pixels = stbi_load(input.c_str(), &image.Width, &image.Height, &channels, 4);
+		if (pixels == nullptr)
+		{
+			printf("Failed to load %s: %s\n", input.c_str(), stbi_failure_reason());
+			return false;
+		}
+		image.Pixels.assign(pixels, pixels + size_t(image.Width) * image.Height * 4);
+		stbi_image_free(pixels);
+
+		if (format == 0)
+			format = HasTransparency(image) ? DXGI_FORMAT_BC3_UNORM : DXGI_FORMAT_BC1_UNORM;
+
+		//Every level down to 1x1
+		uint32_t width = uint32_t(image.Width);
+		uint32_t height = uint32_t(image.Height);
+		std::vector<uint8_t> blocks;
+		uint32_t levels = 0;
+		while (true)
+		{
+			CompressLevel(image, format, blocks);
+			levels++;
+			if (image.Width == 1 && image.Height == 1)
+				break;
+			image = Downsample(image);
+		}
+
+		std::filesystem::path source(input);
+		std::filesystem::path folder = outputFolder.empty() ? source.parent_path() / "cooked" : std::filesystem::path(outputFolder);
+		std::filesystem::create_directories(folder);
+		std::filesystem::path output = folder / (source.filename().string() + ".dds");
+
+		std::ofstream file(output, std::ios::binary);
+		if (!file)
+		{
+			printf("Could not write %s\n", output.string().c_str());
+			return false;
+		}
+
+		DDSHeader header;
+		header.Flags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT | DDSD_LINEARSIZE;
+		header.Width = width;
+		header.Height = height;
+		header.PitchOrLinearSize = ((width + 3) / 4) * ((height + 3) / 4) * DDSBlockBytes(format);
+		header.MipMapCount = levels;
+		header.PixelFormat.Flags = DDPF_FOURCC;
+		header.PixelFormat.FourCC = DDS_FOURCC('D', 'X', '1', '0');
+		header.Caps = DDSCAPS_TEXTURE | DDSCAPS_COMPLEX | DDSCAPS_MIPMAP;
+		DDSHeaderDX10 dx10;
+		dx10.Format = format;
+
+		file.write(reinterpret_cast<const char*>(&DDS_MAGIC), sizeof(uint32_t));
+		file.write(reinterpret_cast<const char*>(&header), sizeof(DDSHeader));
+		file.write(reinterpret_cast<const char*>(&dx10), sizeof(DDSHeaderDX10));
+		file.write(reinterpret_cast<const char*>(blocks.data()), blocks.size());
+
+		printf("%s -> %s (%u levels, %.1f KB)\n", input.c_str(), output.string().c_str(), levels, blocks.size() / 1024.0f);
+		return true;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::vector<std::string> inputs;
+	std::string outputFolder;
+	//0 picks BC1 or BC3 per image
+	uint32_t format = 0;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		if (arg == "--spec")
+			format = DXGI_FORMAT_BC4_UNORM;
+		else if (arg == "--normal")
+			format = DXGI_FORMAT_BC5_UNORM;
+		else if (arg == "--format" && i + 1 < argc)
+		{
+			std::string name = argv[++i];
+			if (name == "bc1") format = DXGI_FORMAT_BC1_UNORM;
+			else if (name == "bc3") format = DXGI_FORMAT_BC3_UNORM;
+			else if (name == "bc4") format = DXGI_FORMAT_BC4_UNORM;
+			else if (name == "bc5") format = DXGI_FORMAT_BC5_UNORM;
+			else
+			{
+				printf("Unknown format %s\n", name.c_str());
+				return 1;
+			}
+		}
+		else if (arg == "--out" && i + 1 < argc)
+			outputFolder = argv[++i];
+		else
+			inputs.push_back(arg);
+	}
+
+	if (inputs.empty())
+	{
+		printf("Usage: TextureCook <image> [more images...] [--format bc1|bc3|bc4|bc5] [--spec] [--normal] [--out <folder>]\n");
+		return 1;
+	}
+
+	int failed = 0;
+	for (const std::string& input : inputs)
+	{
+		if (!Cook(input, outputFolder, format))
+			failed++;
+	}
+	return failed == 0 ? 0 : 1;
+}